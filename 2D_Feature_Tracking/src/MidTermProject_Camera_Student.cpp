@@ -5,6 +5,9 @@
 #include <vector>
 #include <cmath>
 #include <limits>
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
 #include <opencv2/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
@@ -14,205 +17,297 @@
 
 #include "dataStructures.h"
 #include "matching2D.hpp"
+#include "tracker.hpp"
+#include "benchmark.hpp"
+#include "algorithmRegistry.hpp"
+#include "trackingStages.hpp"
+#include "framePack.hpp"
+#include "metrics.hpp"
 
 using namespace std;
 
+static void printUsage(const char *program)
+{
+    cout << "usage: " << program << " [options]" << endl
+         << "  --detector TYPE     SHITOMASI, HARRIS, FAST, BRISK, ORB, AKAZE, SIFT" << endl
+         << "  --descriptor TYPE   BRISK, BRIEF, ORB, FREAK, AKAZE, SIFT" << endl
+         << "  --matcher TYPE      MAT_BF, MAT_FLANN (exact like MAT_BF for binary descriptors), MAT_GUIDED" << endl
+         << "  --selector TYPE     SEL_NN, SEL_KNN, SEL_MUTUAL, SEL_MUTUAL_KNN" << endl
+         << "  --data PATH         directory which contains images/ (default ../)" << endl
+         << "  --pack FILE         read pre-decoded frames from a frame pack instead of the image files" << endl
+         << "  --write-pack FILE   decode the image files once into a frame pack and exit" << endl
+         << "  --budget N          adjust the detector threshold from frame to frame to find about N keypoints per ROI" << endl
+         << "  --budget-ms MS      same, with as many keypoints as can be described and matched (or tracked) in MS per frame" << endl
+         << "  --retention TYPE    RET_BEST, RET_GRID, RET_SSC : which keypoints the ROI and --budget limits keep" << endl
+         << "  --tiled             detect on overlapping tiles of the image or ROIs in parallel" << endl
+         << "  --no-fuse           detect and describe separately even if detector and descriptor are the same algorithm" << endl
+         << "  --klt               track keypoints with Lucas-Kanade, detect only when fewer than --klt-min-tracks survive" << endl
+         << "  --klt-min-tracks N  redetection threshold of --klt (default 50)" << endl
+         << "  --index-dir DIR     save the MAT_FLANN search index of every frame in DIR (created if missing) and load it on later runs" << endl
+         << "  --sequential        process one frame after another instead of pipelining the stages" << endl
+         << "  --headless          no visualization, write per-frame measurements to the output file" << endl
+         << "  --sweep             headless run of every valid detector/descriptor/matcher/selector combination" << endl
+         << "  --jobs N            no. of combinations processed in parallel (default 1)" << endl
+         << "  --output FILE       measurement file, .csv or .json (default benchmark.csv)" << endl
+         << "  --metrics PREFIX    record latency histograms, written to PREFIX.json and PREFIX.prom at exit" << endl
+         << "  --metrics-every S   additionally write the metrics files every S seconds" << endl;
+}
+
 /* MAIN PROGRAM */
 int main(int argc, const char *argv[])
 {
 
     /* INIT VARIABLES AND DATA STRUCTURES */
 
-    // data location
-    string dataPath = "../";
-
-    // camera
-    string imgBasePath = dataPath + "images/";
-    string imgPrefix = "KITTI/2011_09_26/image_00/data/000000"; // left camera, color
-    string imgFileType = ".png";
-    int imgStartIndex = 0; // first file index to load (assumes Lidar and camera names have identical naming convention)
-    int imgEndIndex = 9;   // last file index to load
-    int imgFillWidth = 4;  // no. of digits which make up the file index (e.g. img-0001.png)
-
-    // misc
-    int dataBufferSize = 2;       // no. of images which are held in memory (ring buffer) at the same time
-    vector<DataFrame> dataBuffer; // list of data frames which are held in memory at the same time
-    bool bVis = false;            // visualize results
+    TrackerConfig config;  // image sequence, algorithms and execution settings, see tracker.hpp for the defaults
+    bool bVis = true;      // visualize results
+    bool bSweep = false;   // benchmark all combinations
+    int numJobs = 1;       // no. of benchmark combinations run in parallel
+    string outputFile = "benchmark.csv";
+    string writePackFile;  // frame pack to create from the image files
+    string metricsPrefix;  // latency histogram export, disabled if empty
+    double metricsInterval = 0.0; // seconds between periodic exports, 0 = only at exit
 
-    string detectorType = "FAST"; // SHITOMASI, HARRIS, FAST, BRISK, ORB, AKAZE, SIFT
-    string descriptorType = "BRIEF"; // BRISK, BRIEF, ORB, FREAK, AKAZE, SIFT
-    string matcherType = "MAT_BF";        // MAT_BF, MAT_FLANN
-    string descriptorDataType = "DES_BINARY"; // DES_BINARY, DES_HOG
-    string selectorType = "SEL_KNN";       // SEL_NN, SEL_KNN
+    /* PARSE COMMAND LINE */
 
-    /* MAIN LOOP OVER ALL IMAGES */
-
-    for (size_t imgIndex = 0; imgIndex <= imgEndIndex - imgStartIndex; imgIndex++)
+    // unknown algorithm names and unsupported combinations are rejected here, before any frame is processed
+    try
     {
-        /* LOAD IMAGE INTO BUFFER */
-
-        // assemble filenames for current index
-        ostringstream imgNumber;
-        imgNumber << setfill('0') << setw(imgFillWidth) << imgStartIndex + imgIndex;
-        string imgFullFilename = imgBasePath + imgPrefix + imgNumber.str() + imgFileType;
-
-        // load image from file and convert to grayscale
-        cv::Mat img, imgGray;
-        img = cv::imread(imgFullFilename);
-        cv::cvtColor(img, imgGray, cv::COLOR_BGR2GRAY);
-
-        //// STUDENT ASSIGNMENT
-        //// TASK MP.1 -> replace the following code with ring buffer of size dataBufferSize
-        if(dataBuffer.size()==dataBufferSize)
+        for (int i = 1; i < argc; ++i)
+        {
+            string arg = argv[i];
+            bool bHasValue = i + 1 < argc;
+            if (!arg.compare("--detector") && bHasValue)
+            {
+                config.detectorKind = parseDetectorKind(argv[++i]);
+            }
+            else if (!arg.compare("--descriptor") && bHasValue)
+            {
+                config.descriptorKind = parseDescriptorKind(argv[++i]);
+            }
+            else if (!arg.compare("--matcher") && bHasValue)
+            {
+                config.matcherKind = parseMatcherKind(argv[++i]);
+            }
+            else if (!arg.compare("--selector") && bHasValue)
+            {
+                config.selectorKind = parseSelectorKind(argv[++i]);
+            }
+            else if (!arg.compare("--data") && bHasValue)
+            {
+                config.imgBasePath = string(argv[++i]) + "/images/";
+            }
+            else if (!arg.compare("--pack") && bHasValue)
+            {
+                config.framePackFile = argv[++i];
+            }
+            else if (!arg.compare("--write-pack") && bHasValue)
+            {
+                writePackFile = argv[++i];
+            }
+            else if (!arg.compare("--budget") && bHasValue)
+            {
+                config.bKeypointBudget = true;
+                config.budgetKeypoints = atoi(argv[++i]);
+            }
+            else if (!arg.compare("--budget-ms") && bHasValue)
+            {
+                config.bKeypointBudget = true;
+                config.budgetTimeMs = atof(argv[++i]);
+            }
+            else if (!arg.compare("--retention") && bHasValue)
+            {
+                config.retentionKind = parseRetentionKind(argv[++i]);
+            }
+            else if (!arg.compare("--tiled"))
+            {
+                config.bTiledDetection = true;
+            }
+            else if (!arg.compare("--no-fuse"))
+            {
+                config.bFuseDetectDescribe = false;
+            }
+            else if (!arg.compare("--klt"))
+            {
+                config.bKlt = true;
+            }
+            else if (!arg.compare("--klt-min-tracks") && bHasValue)
+            {
+                config.kltMinTracks = atoi(argv[++i]);
+            }
+            else if (!arg.compare("--index-dir") && bHasValue)
+            {
+                config.indexDir = argv[++i];
+            }
+            else if (!arg.compare("--metrics") && bHasValue)
+            {
+                metricsPrefix = argv[++i];
+            }
+            else if (!arg.compare("--metrics-every") && bHasValue)
+            {
+                metricsInterval = atof(argv[++i]);
+            }
+            else if (!arg.compare("--jobs") && bHasValue)
+            {
+                numJobs = atoi(argv[++i]);
+            }
+            else if (!arg.compare("--output") && bHasValue)
+            {
+                outputFile = argv[++i];
+            }
+            else if (!arg.compare("--sequential"))
+            {
+                config.bPipelined = false;
+            }
+            else if (!arg.compare("--headless"))
+            {
+                bVis = false;
+            }
+            else if (!arg.compare("--sweep"))
+            {
+                bSweep = true;
+                bVis = false;
+            }
+            else
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+        if (!bSweep)
         {
-            dataBuffer.erase(dataBuffer.begin());
+            selectStages(config.detectorKind, config.descriptorKind, config.matcherKind, config.selectorKind);
         }
+    }
+    catch (const invalid_argument &ia)
+    {
+        cout << ia.what() << endl;
+        return 1;
+    }
 
-        // push image into data frame buffer
-        DataFrame frame;
-        frame.cameraImg = imgGray;
-        dataBuffer.push_back(frame);
-
-        //// EOF STUDENT ASSIGNMENT
-        cout << "#1 : LOAD IMAGE INTO BUFFER done" << endl;
-
-        /* DETECT IMAGE KEYPOINTS */
-
-        // extract 2D keypoints from current image
-        vector<cv::KeyPoint> keypoints; // create empty feature list for current image
-
-        //// STUDENT ASSIGNMENT
-        //// TASK MP.2 -> add the following keypoint detectors in file matching2D.cpp and enable string-based selection based on detectorType
-        //// -> HARRIS, FAST, BRISK, ORB, AKAZE, SIFT
+    /* FRAME PACK CONVERSION */
 
-        if (!detectorType.compare("SHITOMASI"))
+    if (!writePackFile.empty())
+    {
+        try
         {
-            detKeypointsShiTomasi(keypoints, imgGray, false);
+            writeFramePack(imageSequence(config), writePackFile, false);
         }
-        else if(!detectorType.compare("HARRIS"))
+        catch (const runtime_error &re)
         {
-            detKeypointsHarris(keypoints,imgGray,false);
+            cout << re.what() << endl;
+            return 1;
         }
-        else
+        cout << "frame pack written to " << writePackFile << endl;
+        return 0;
+    }
+
+    /* METRICS */
+
+    // periodic export happens on a background thread, the final export when main returns
+    struct MetricsExport {
+        string prefix;
+        ~MetricsExport()
         {
+            if (prefix.empty())
+            {
+                return;
+            }
             try
             {
-                detKeypointsModern(keypoints,imgGray,detectorType,false);
+                Metrics::instance().stopExport();
+                Metrics::instance().exportFiles(prefix);
             }
-            catch(const invalid_argument& exp)
+            catch (const runtime_error &re)
             {
-                cout<<exp.what()<<endl;
+                cout << re.what() << endl;
             }
         }
-        //// EOF STUDENT ASSIGNMENT
-
-        //// STUDENT ASSIGNMENT
-        //// TASK MP.3 -> only keep keypoints on the preceding vehicle
-
-        // only keep keypoints on the preceding vehicle
-        bool bFocusOnVehicle = true;
-        cv::Rect vehicleRect(535, 180, 180, 150);
-        if (bFocusOnVehicle)
+    } metricsExport;
+    if (!metricsPrefix.empty())
+    {
+        Metrics::setEnabled(true);
+        metricsExport.prefix = metricsPrefix;
+        if (metricsInterval > 0.0)
         {
-            vector<cv::KeyPoint> focusedKeypoints;
-            for(auto it=keypoints.begin();it!=keypoints.end();++it)
-            {
-                if(vehicleRect.contains(it->pt))
-                {
-                    focusedKeypoints.push_back(*it);
-                }
-            }
-            keypoints=focusedKeypoints;
+            Metrics::instance().startExport(metricsPrefix, metricsInterval);
         }
+    }
 
-        cout<<"---> keypoints on preceding vehicle = "<<keypoints.size()<<endl;
-
-        //// EOF STUDENT ASSIGNMENT
+    /* HEADLESS BENCHMARK */
 
-        // optional : limit number of keypoints (helpful for debugging and learning)
-        bool bLimitKpts = false;
-        if (bLimitKpts)
+    if (!bVis)
+    {
+        vector<BenchmarkCombination> combinations;
+        if (bSweep)
         {
-            int maxKeypoints = 50;
-
-            if (!detectorType.compare("SHITOMASI"))
-            { // there is no response info, so keep the first 50 as they are sorted in descending quality order
-                keypoints.erase(keypoints.begin() + maxKeypoints, keypoints.end());
-            }
-            cv::KeyPointsFilter::retainBest(keypoints, maxKeypoints);
-            cout << " NOTE: Keypoints have been limited!" << endl;
+            combinations = allCombinations();
         }
-
-        // push keypoints and descriptor for current frame to end of data buffer
-        (dataBuffer.end() - 1)->keypoints = keypoints;
-        cout << "#2 : DETECT KEYPOINTS done" << endl;
-
-        /* EXTRACT KEYPOINT DESCRIPTORS */
-
-        //// STUDENT ASSIGNMENT
-        //// TASK MP.4 -> add the following descriptors in file matching2D.cpp and enable string-based selection based on descriptorType
-        //// -> BRIEF, ORB, FREAK, AKAZE, SIFT
-
-        cv::Mat descriptors;
-        descKeypoints((dataBuffer.end() - 1)->keypoints, (dataBuffer.end() - 1)->cameraImg, descriptors, descriptorType);
-        //// EOF STUDENT ASSIGNMENT
-
-        // push descriptors for current frame to end of data buffer
-        (dataBuffer.end() - 1)->descriptors = descriptors;
-
-        cout << "#3 : EXTRACT DESCRIPTORS done" << endl;
-
-        if (dataBuffer.size() > 1) // wait until at least two images have been processed
+        else
         {
+            BenchmarkCombination combination;
+            combination.detectorKind = config.detectorKind;
+            combination.descriptorKind = config.descriptorKind;
+            combination.matcherKind = config.matcherKind;
+            combination.selectorKind = config.selectorKind;
+            combinations.push_back(combination);
+        }
 
-            /* MATCH KEYPOINT DESCRIPTORS */
+        // parallelism comes from running several combinations at once, each of them runs sequentially
+        config.bVerbose = false;
+        config.bPipelined = config.bPipelined && combinations.size() == 1;
 
-            vector<cv::DMatch> matches;
+        size_t numFailed = 0;
+        vector<BenchmarkRow> rows = runBenchmark(config, combinations, numJobs, numFailed);
+        try
+        {
+            writeBenchmarkRows(rows, outputFile);
+        }
+        catch (const runtime_error &re)
+        {
+            cout << re.what() << endl;
+            return 1;
+        }
+        cout << rows.size() << " rows written to " << outputFile << endl;
+        AlgorithmRegistry::instance().printStats(cout); // one-time construction cost, not part of the frame timings
+        if (numFailed > 0)
+        {
+            cout << numFailed << " of " << combinations.size() << " combinations failed" << endl;
+            return 1;
+        }
+        return 0;
+    }
 
-            //// STUDENT ASSIGNMENT
-            //// TASK MP.5 -> add FLANN matching in file matching2D.cpp
-            //// TASK MP.6 -> add KNN match selection and perform descriptor distance ratio filtering with t=0.8 in file matching2D.cpp
+    /* MAIN LOOP OVER ALL IMAGES */
 
-            try
-            {
-                matchDescriptors((dataBuffer.end() - 2)->keypoints, (dataBuffer.end() - 1)->keypoints,
-                                 (dataBuffer.end() - 2)->descriptors, (dataBuffer.end() - 1)->descriptors,
-                                 matches, descriptorDataType, matcherType, selectorType);
-                std::cout<<"# matches: "<<matches.size()<<std::endl;
-            }
-            catch(const invalid_argument& ia)
+    try
+    {
+        runTracker(config, [](DataFrame *prevFrame, DataFrame &frame) {
+            if (prevFrame == NULL)
             {
-                cout<<ia.what()<<endl;
+                return;
             }
 
-            //// EOF STUDENT ASSIGNMENT
-
-            // store matches in current data frame
-            (dataBuffer.end() - 1)->kptMatches = matches;
-
-            cout << "#4 : MATCH KEYPOINT DESCRIPTORS done" << endl;
-
             // visualize matches between current and previous image
-            bVis = true;
-            if (bVis)
-            {
-                cv::Mat matchImg = ((dataBuffer.end() - 1)->cameraImg).clone();
-                cv::drawMatches((dataBuffer.end() - 2)->cameraImg, (dataBuffer.end() - 2)->keypoints,
-                                (dataBuffer.end() - 1)->cameraImg, (dataBuffer.end() - 1)->keypoints,
-                                matches, matchImg,
-                                cv::Scalar::all(-1), cv::Scalar::all(-1),
-                                vector<char>(), cv::DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
-
-                string windowName = "Matching keypoints between two camera images";
-                cv::namedWindow(windowName, 7);
-                cv::imshow(windowName, matchImg);
-                cout << "Press key to continue to next image" << endl;
-                cv::waitKey(0); // wait for key to be pressed
-            }
-            bVis = false;
-        }
-
-    } // eof loop over all images
+            cv::Mat matchImg = (frame.cameraImg).clone();
+            cv::drawMatches(prevFrame->cameraImg, prevFrame->keypoints,
+                            frame.cameraImg, frame.keypoints,
+                            frame.kptMatches, matchImg,
+                            cv::Scalar::all(-1), cv::Scalar::all(-1),
+                            vector<char>(), cv::DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
+
+            string windowName = "Matching keypoints between two camera images";
+            cv::namedWindow(windowName, 7);
+            cv::imshow(windowName, matchImg);
+            cout << "Press key to continue to next image" << endl;
+            cv::waitKey(0); // wait for key to be pressed
+        });
+    }
+    catch (const exception &e)
+    { // e.g. a missing image or frame pack, or an index directory which cannot be written
+        cout << e.what() << endl;
+        return 1;
+    }
 
     return 0;
-}
\ No newline at end of file
+}
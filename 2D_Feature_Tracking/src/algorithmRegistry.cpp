@@ -0,0 +1,144 @@
+#include <sstream>
+#include <stdexcept>
+#include <opencv2/xfeatures2d.hpp>
+#include <opencv2/xfeatures2d/nonfree.hpp>
+
+#include "algorithmRegistry.hpp"
+
+using namespace std;
+
+AlgorithmRegistry &AlgorithmRegistry::instance()
+{
+    static AlgorithmRegistry registry;
+    return registry;
+}
+
+template <typename T, typename Factory>
+cv::Ptr<T> AlgorithmRegistry::lookup(const string &key, bool bReentrant, Factory factory)
+{
+    static Cache<T> sharedCache;              // reentrant objects, used by all threads
+    static thread_local Cache<T> threadCache; // objects with internal state, one set per thread
+
+    lookups++;
+    unique_lock<mutex> lock(sharedMutex, defer_lock);
+    Cache<T> &cache = bReentrant ? sharedCache : threadCache;
+    if (bReentrant)
+    {
+        lock.lock();
+    }
+
+    auto it = cache.instances.find(key);
+    if (it != cache.instances.end())
+    {
+        return it->second;
+    }
+
+    int64 t = cv::getTickCount();
+    cv::Ptr<T> object = factory();
+    constructionTicks += cv::getTickCount() - t;
+    constructions++;
+
+    cache.instances[key] = object;
+    return object;
+}
+
+cv::Ptr<cv::FeatureDetector> AlgorithmRegistry::detector(DetectorKind detectorKind)
+{
+    switch (detectorKind)
+    {
+    case DetectorKind::FAST:
+        return lookup<cv::Feature2D>("detector/FAST", true, []() { return cv::FastFeatureDetector::create(); });
+    case DetectorKind::BRISK:
+        return lookup<cv::Feature2D>("detector/BRISK", true, []() { return cv::BRISK::create(); });
+    case DetectorKind::ORB:
+        return lookup<cv::Feature2D>("detector/ORB", true, []() { return cv::ORB::create(); });
+    case DetectorKind::AKAZE:
+        return lookup<cv::Feature2D>("detector/AKAZE", true, []() { return cv::AKAZE::create(); });
+    case DetectorKind::SIFT:
+        return lookup<cv::Feature2D>("detector/SIFT", true, []() { return cv::xfeatures2d::SIFT::create(); });
+    default:
+        throw invalid_argument(string("invalid detectorType ") + toString(detectorKind));
+    }
+}
+
+cv::Ptr<cv::FeatureDetector> AlgorithmRegistry::detector(DetectorKind detectorKind, double threshold)
+{
+    if (threshold <= 0)
+    {
+        return detector(detectorKind);
+    }
+
+    // all other parameters stay at their defaults, so the extractor of a fused pair still matches its detector
+    ostringstream key;
+    key << "detector/" << toString(detectorKind) << "/" << threshold;
+    switch (detectorKind)
+    {
+    case DetectorKind::FAST:
+        return lookup<cv::Feature2D>(key.str(), true, [=]() { return cv::FastFeatureDetector::create((int)threshold); });
+    case DetectorKind::BRISK:
+        return lookup<cv::Feature2D>(key.str(), true, [=]() { return cv::BRISK::create((int)threshold); });
+    case DetectorKind::ORB:
+        return lookup<cv::Feature2D>(key.str(), true, [=]() {
+            return cv::ORB::create(500, 1.2f, 8, 31, 0, 2, cv::ORB::HARRIS_SCORE, 31, (int)threshold);
+        });
+    case DetectorKind::AKAZE:
+        return lookup<cv::Feature2D>(key.str(), true, [=]() {
+            return cv::AKAZE::create(cv::AKAZE::DESCRIPTOR_MLDB, 0, 3, (float)threshold);
+        });
+    case DetectorKind::SIFT:
+        return lookup<cv::Feature2D>(key.str(), true, [=]() { return cv::xfeatures2d::SIFT::create(0, 3, threshold); });
+    default:
+        throw invalid_argument(string("invalid detectorType ") + toString(detectorKind));
+    }
+}
+
+cv::Ptr<cv::DescriptorExtractor> AlgorithmRegistry::extractor(DescriptorKind descriptorKind)
+{
+    switch (descriptorKind)
+    {
+    case DescriptorKind::BRISK:
+    {
+        int threshold = 30;        // FAST/AGAST detection threshold score.
+        int octaves = 3;           // detection octaves (use 0 to do single scale)
+        float patternScale = 1.0f; // apply this scale to the pattern used for sampling the neighbourhood of a keypoint.
+
+        return lookup<cv::Feature2D>("extractor/BRISK/30/3/1.0", true,
+                                     [=]() { return cv::BRISK::create(threshold, octaves, patternScale); });
+    }
+    case DescriptorKind::BRIEF:
+        return lookup<cv::Feature2D>("extractor/BRIEF", true, []() { return cv::xfeatures2d::BriefDescriptorExtractor::create(); });
+    case DescriptorKind::ORB:
+        return lookup<cv::Feature2D>("extractor/ORB", true, []() { return cv::ORB::create(); });
+    case DescriptorKind::FREAK: // the pattern lookup table is built on the first compute call
+        return lookup<cv::Feature2D>("extractor/FREAK", false, []() { return cv::xfeatures2d::FREAK::create(); });
+    case DescriptorKind::AKAZE:
+        return lookup<cv::Feature2D>("extractor/AKAZE", true, []() { return cv::AKAZE::create(); });
+    case DescriptorKind::SIFT:
+        return lookup<cv::Feature2D>("extractor/SIFT", true, []() { return cv::xfeatures2d::SIFT::create(); });
+    default:
+        throw invalid_argument(string("invalid descriptorType ") + toString(descriptorKind));
+    }
+}
+
+cv::Ptr<cv::Feature2D> AlgorithmRegistry::orbLevel(int nfeatures, int fastThreshold)
+{
+    return lookup<cv::Feature2D>("ORB/level/" + to_string(nfeatures) + "/" + to_string(fastThreshold), true, [=]() {
+        return cv::ORB::create(nfeatures, 1.2f, 1, 31, 0, 2, cv::ORB::HARRIS_SCORE, 31, fastThreshold);
+    });
+}
+
+RegistryStats AlgorithmRegistry::stats() const
+{
+    RegistryStats s;
+    s.lookups = lookups.load();
+    s.constructions = constructions.load();
+    s.constructionTime = 1000.0 * constructionTicks.load() / cv::getTickFrequency();
+    return s;
+}
+
+void AlgorithmRegistry::printStats(ostream &os) const
+{
+    RegistryStats s = stats();
+    os << "algorithm registry : " << s.constructions << " objects built in " << s.constructionTime << " ms, "
+       << s.lookups << " lookups" << endl;
+}
@@ -0,0 +1,63 @@
+#ifndef algorithmRegistry_hpp
+#define algorithmRegistry_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+
+#include "featureTypes.hpp"
+
+
+struct RegistryStats { // construction cost is kept apart from the per-frame cost measured by the callers
+    uint64_t lookups;        // no. of requests for an algorithm object
+    uint64_t constructions;  // no. of objects which had to be built
+    double constructionTime; // total time spent in constructors in [ms]
+};
+
+
+// builds every configured detector and extractor once and hands out the same object on later requests
+// objects are keyed by type and parameters; algorithms which keep mutable state while processing an image
+// (FREAK builds its pattern lookup lazily) get one instance per thread
+class AlgorithmRegistry
+{
+public:
+    static AlgorithmRegistry &instance();
+
+    // FAST, BRISK, ORB, AKAZE, SIFT (SHITOMASI and HARRIS are plain functions, requesting them throws invalid_argument)
+    cv::Ptr<cv::FeatureDetector> detector(DetectorKind detectorKind);
+    // same detector with its threshold (see detectorThresholdRange) set to threshold, one object per value, 0 = default
+    cv::Ptr<cv::FeatureDetector> detector(DetectorKind detectorKind, double threshold);
+    // BRISK, BRIEF, ORB, FREAK, AKAZE, SIFT
+    cv::Ptr<cv::DescriptorExtractor> extractor(DescriptorKind descriptorKind);
+    // ORB with a single pyramid level which keeps the nfeatures best keypoints, otherwise as cv::ORB::create(),
+    // for running ORB on the levels of a pyramid built outside of it
+    cv::Ptr<cv::Feature2D> orbLevel(int nfeatures, int fastThreshold = 20);
+
+    RegistryStats stats() const;
+    void printStats(std::ostream &os) const;
+
+private:
+    template <typename T>
+    struct Cache {
+        std::map<std::string, cv::Ptr<T> > instances;
+    };
+
+    AlgorithmRegistry() : lookups(0), constructions(0), constructionTicks(0) {}
+
+    // returns the cached object for key, creating it with factory on first use
+    template <typename T, typename Factory>
+    cv::Ptr<T> lookup(const std::string &key, bool bReentrant, Factory factory);
+
+    std::mutex sharedMutex; // guards the caches of reentrant objects which are shared by all threads
+    std::atomic<uint64_t> lookups;
+    std::atomic<uint64_t> constructions;
+    std::atomic<int64_t> constructionTicks;
+};
+
+#endif /* algorithmRegistry_hpp */
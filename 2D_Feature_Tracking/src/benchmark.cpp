@@ -0,0 +1,158 @@
+#include <iostream>
+#include <fstream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <stdexcept>
+
+#include "benchmark.hpp"
+
+using namespace std;
+
+vector<BenchmarkCombination> allCombinations()
+{
+    vector<BenchmarkCombination> combinations;
+    for (int detector = 0; detector < NUM_DETECTOR_KINDS; ++detector)
+    {
+        for (int descriptor = 0; descriptor < NUM_DESCRIPTOR_KINDS; ++descriptor)
+        {
+            BenchmarkCombination combination;
+            combination.detectorKind = static_cast<DetectorKind>(detector);
+            combination.descriptorKind = static_cast<DescriptorKind>(descriptor);
+            if (!isValidCombination(combination.detectorKind, combination.descriptorKind))
+            {
+                continue;
+            }
+            for (int matcher = 0; matcher < NUM_MATCHER_KINDS; ++matcher)
+            {
+                for (int selector = 0; selector < NUM_SELECTOR_KINDS; ++selector)
+                {
+                    combination.matcherKind = static_cast<MatcherKind>(matcher);
+                    combination.selectorKind = static_cast<SelectorKind>(selector);
+                    combinations.push_back(combination);
+                }
+            }
+        }
+    }
+    return combinations;
+}
+
+// DETECTOR/DESCRIPTOR/MATCHER/SELECTOR
+static string combinationName(const BenchmarkCombination &combination)
+{
+    return string(toString(combination.detectorKind)) + "/" + toString(combination.descriptorKind) + "/" +
+           toString(combination.matcherKind) + "/" + toString(combination.selectorKind);
+}
+
+vector<BenchmarkRow> runBenchmark(const TrackerConfig &baseConfig, const vector<BenchmarkCombination> &combinations, int numJobs,
+                                  size_t &numFailed)
+{
+    // every combination collects its own rows, so no locking is needed while the jobs run
+    vector<vector<BenchmarkRow> > results(combinations.size());
+    atomic<size_t> nextCombination(0), failed(0);
+    mutex logMutex;
+
+    auto worker = [&]() {
+        for (size_t i = nextCombination++; i < combinations.size(); i = nextCombination++)
+        {
+            const BenchmarkCombination &combination = combinations[i];
+            TrackerConfig config = baseConfig;
+            config.detectorKind = combination.detectorKind;
+            config.descriptorKind = combination.descriptorKind;
+            config.matcherKind = combination.matcherKind;
+            config.selectorKind = combination.selectorKind;
+
+            vector<BenchmarkRow> &rows = results[i];
+            try
+            {
+                runTracker(config, [&](DataFrame *, DataFrame &frame) {
+                    BenchmarkRow row;
+                    row.combination = combination;
+                    row.stats = frame.stats;
+                    rows.push_back(row);
+                });
+            }
+            catch (const exception &e)
+            { // keep the rows collected so far and go on with the next combination
+                ++failed;
+                lock_guard<mutex> lock(logMutex);
+                cerr << combinationName(combination) << " failed: " << e.what() << endl;
+            }
+
+            lock_guard<mutex> lock(logMutex);
+            cout << "[" << i + 1 << "/" << combinations.size() << "] " << combinationName(combination)
+                 << " : " << rows.size() << " frames" << endl;
+        }
+    };
+
+    numJobs = max(1, numJobs);
+    vector<thread> jobs;
+    for (int j = 1; j < numJobs; ++j)
+    {
+        jobs.push_back(thread(worker));
+    }
+    worker();
+    for (auto &job : jobs)
+    {
+        job.join();
+    }
+
+    numFailed = failed;
+    vector<BenchmarkRow> rows;
+    for (auto &combinationRows : results)
+    {
+        rows.insert(rows.end(), combinationRows.begin(), combinationRows.end());
+    }
+    return rows;
+}
+
+static void writeCsv(const vector<BenchmarkRow> &rows, ostream &os)
+{
+    os << "detector,descriptor,matcher,selector,frame,load_ms,decode_ms,detect_ms,pyramid_ms,describe_ms,match_ms,detected_keypoints,keypoints,matches,set_point,threshold" << endl;
+    for (const BenchmarkRow &row : rows)
+    {
+        const FrameStats &s = row.stats;
+        os << toString(row.combination.detectorKind) << "," << toString(row.combination.descriptorKind) << ","
+           << toString(row.combination.matcherKind) << "," << toString(row.combination.selectorKind) << ","
+           << s.frameIndex << "," << s.loadTime << "," << s.decodeTime << "," << s.detectTime << "," << s.pyramidTime << "," << s.describeTime << "," << s.matchTime << ","
+           << s.numDetectedKpts << "," << s.numKeypoints << "," << s.numMatches << "," << s.keypointSetPoint << "," << s.detectorThreshold << endl;
+    }
+}
+
+static void writeJson(const vector<BenchmarkRow> &rows, ostream &os)
+{
+    os << "[" << endl;
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        const BenchmarkRow &row = rows[i];
+        const FrameStats &s = row.stats;
+        os << "  {\"detector\": \"" << toString(row.combination.detectorKind) << "\", \"descriptor\": \"" << toString(row.combination.descriptorKind)
+           << "\", \"matcher\": \"" << toString(row.combination.matcherKind) << "\", \"selector\": \"" << toString(row.combination.selectorKind)
+           << "\", \"frame\": " << s.frameIndex << ", \"load_ms\": " << s.loadTime << ", \"decode_ms\": " << s.decodeTime
+           << ", \"detect_ms\": " << s.detectTime << ", \"pyramid_ms\": " << s.pyramidTime
+           << ", \"describe_ms\": " << s.describeTime << ", \"match_ms\": " << s.matchTime
+           << ", \"detected_keypoints\": " << s.numDetectedKpts << ", \"keypoints\": " << s.numKeypoints
+           << ", \"matches\": " << s.numMatches << ", \"set_point\": " << s.keypointSetPoint
+           << ", \"threshold\": " << s.detectorThreshold << "}" << (i + 1 < rows.size() ? "," : "") << endl;
+    }
+    os << "]" << endl;
+}
+
+void writeBenchmarkRows(const vector<BenchmarkRow> &rows, const string &fileName)
+{
+    ofstream out(fileName);
+    if (!out)
+    {
+        throw runtime_error("could not open " + fileName);
+    }
+
+    bool bJson = fileName.size() >= 5 && fileName.compare(fileName.size() - 5, 5, ".json") == 0;
+    if (bJson)
+    {
+        writeJson(rows, out);
+    }
+    else
+    {
+        writeCsv(rows, out);
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef benchmark_hpp
+#define benchmark_hpp
+
+#include <string>
+#include <vector>
+
+#include "tracker.hpp"
+
+
+struct BenchmarkCombination { // one detector / descriptor / matcher / selector setting of a benchmark run
+    DetectorKind detectorKind;
+    DescriptorKind descriptorKind;
+    MatcherKind matcherKind;
+    SelectorKind selectorKind;
+};
+
+struct BenchmarkRow { // measurements of one frame processed with one combination
+    BenchmarkCombination combination;
+    FrameStats stats;
+};
+
+// all valid combinations of SHITOMASI/HARRIS/FAST/BRISK/ORB/AKAZE/SIFT x BRIEF/ORB/FREAK/AKAZE/SIFT/BRISK
+// x MAT_BF/MAT_FLANN/MAT_GUIDED x SEL_NN/SEL_KNN/SEL_MUTUAL/SEL_MUTUAL_KNN
+std::vector<BenchmarkCombination> allCombinations();
+
+// run every combination headless on the image sequence of baseConfig, numJobs combinations at a time
+// rows are returned in the order of the combinations, independent of numJobs
+// a combination which throws keeps the rows of the frames before and is counted in numFailed
+std::vector<BenchmarkRow> runBenchmark(const TrackerConfig &baseConfig, const std::vector<BenchmarkCombination> &combinations, int numJobs,
+                                       size_t &numFailed);
+
+// write one row per frame and combination, the format is chosen from the file extension (.json or .csv)
+void writeBenchmarkRows(const std::vector<BenchmarkRow> &rows, const std::string &fileName);
+
+#endif /* benchmark_hpp */
@@ -2,8 +2,39 @@
 #define dataStructures_h
 
 #include <vector>
+#include <cstddef>
+#include <memory>
 #include <opencv2/core.hpp>
 
+#include "imagePyramid.hpp"
+#include "featureTypes.hpp"
+
+class DescriptorIndex;
+
+
+struct DetectionRoi { // image region which is searched for keypoints
+    cv::Rect rect;         // region in image coordinates
+    int maxKeypoints;      // keypoint budget of this region, strongest ones are kept (0 = unlimited)
+    double threshold;      // detector threshold in this region, see detectorThresholdRange (0 = detector default)
+    RetentionKind retention; // which keypoints the budget keeps, RET_BEST unless set
+};
+
+
+struct FrameStats { // measurements taken while a frame passes the processing stages
+    size_t frameIndex = 0;         // index of the image within the sequence
+    double loadTime = 0.0;         // waiting for the decoded image in [ms], near zero while read-ahead keeps up
+    double decodeTime = 0.0;       // grayscale image decoding on a background thread in [ms]
+    double detectTime = 0.0;       // keypoint detection and filtering in [ms]
+    double pyramidTime = 0.0;      // image pyramid construction in [ms], once per frame and part of detectTime
+    double describeTime = 0.0;     // descriptor extraction in [ms]
+    double matchTime = 0.0;        // descriptor matching against the previous frame in [ms]
+    size_t numDetectedKpts = 0;    // no. of keypoints found by the detector
+    size_t numKeypoints = 0;       // no. of keypoints left after ROI filtering and limiting
+    size_t numMatches = 0;         // no. of matches with the previous frame
+    int keypointSetPoint = 0;      // keypoint budget : keypoints the thresholds aimed for (0 = no budget)
+    double detectorThreshold = 0.0; // keypoint budget : detector threshold used in the first region
+};
+
 
 struct DataFrame { // represents the available sensor information at the same time instance
     
@@ -12,6 +43,61 @@ struct DataFrame { // represents the available sensor information at the same ti
     std::vector<cv::KeyPoint> keypoints; // 2D keypoints within camera image
     cv::Mat descriptors; // keypoint descriptors
     std::vector<cv::DMatch> kptMatches; // keypoint matches between previous and current frame
+    cv::Mat motion; // 3x3 homography from previous to current frame estimated from kptMatches, empty if unknown
+    std::shared_ptr<const DescriptorIndex> descIndex; // search index over descriptors, built on first use by FrameIndexMatcher
+    ImagePyramid pyramid; // pyramid of cameraImg within pyramidRect, built once per frame and read by KLT tracking and ORB
+    cv::Rect pyramidRect; // empty until the pyramid of the current image is built
+
+    FrameStats stats; // stage timings and counts of this frame
+
+    // drop the results of the previous use of this frame while keeping the allocated storage
+    void reset()
+    {
+        keypoints.clear();
+        kptMatches.clear();
+        motion.release();
+        descIndex.reset();
+        pyramidRect = cv::Rect(); // the levels keep their storage for the next build
+        stats = FrameStats();
+    }
+};
+
+
+class DataFrameBuffer { // fixed-capacity ring buffer of data frames, slots and their storage are reused
+public:
+    explicit DataFrameBuffer(size_t capacity) : slots(capacity > 0 ? capacity : 1), next(0), count(0) {}
+
+    // advance to the next slot, overwriting the oldest frame once the buffer is full
+    // the returned frame still owns the image, descriptor and vector storage of the frame it replaces
+    DataFrame &push()
+    {
+        DataFrame &frame = slots[next];
+        frame.reset();
+        next = (next + 1) % slots.size();
+        if (count < slots.size())
+        {
+            ++count;
+        }
+        return frame;
+    }
+
+    // n-th newest frame, back(0) is the frame added last
+    DataFrame &back(size_t n = 0) { return slots[(next + slots.size() - 1 - n) % slots.size()]; }
+    const DataFrame &back(size_t n = 0) const { return slots[(next + slots.size() - 1 - n) % slots.size()]; }
+
+    // i-th frame counted from the oldest one in the buffer
+    DataFrame &operator[](size_t i) { return slots[(next + slots.size() - count + i) % slots.size()]; }
+    const DataFrame &operator[](size_t i) const { return slots[(next + slots.size() - count + i) % slots.size()]; }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return slots.size(); }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == slots.size(); }
+
+private:
+    std::vector<DataFrame> slots; // preallocated once, never resized
+    size_t next;                  // slot which is written by the next push
+    size_t count;                 // no. of valid frames
 };
 
 
@@ -0,0 +1,114 @@
+// check that describing on the crop of descriptorSupportRect (descKeypoints) gives the descriptors of the whole image,
+// for every descriptor on keypoints of the vehicle ROI of the KITTI frames, detected with a detector it accepts
+// ORB is also described on the frame pyramid (descKeypointsOrbPyramid) as the tracker does it
+// binary descriptors must agree bit by bit, SIFT up to a small part of its norm
+// usage : descriptor_crop_check [data directory which contains images/, default ../]
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <cmath>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "matching2D.hpp"
+#include "tracker.hpp"
+#include "algorithmRegistry.hpp"
+#include "framePyramid.hpp"
+
+using namespace std;
+
+static const double MAX_RELATIVE_L2 = 1e-3; // SIFT : distance between both descriptors relative to the descriptor norm
+
+static bool sameKeypoint(const cv::KeyPoint &p, const cv::KeyPoint &q)
+{
+    return p.pt == q.pt && p.size == q.size && p.angle == q.angle && p.octave == q.octave;
+}
+
+int main(int argc, const char *argv[])
+{
+    TrackerConfig config;
+    if (argc > 1)
+    {
+        config.imgBasePath = string(argv[1]) + "/images/";
+    }
+
+    vector<cv::Mat> frames;
+    ImageSequence sequence = imageSequence(config);
+    for (size_t i = 0; i < sequence.size(); ++i)
+    {
+        cv::Mat img = cv::imread(sequence.fileName(i), cv::IMREAD_GRAYSCALE);
+        if (img.empty())
+        {
+            cerr << "could not read " << sequence.fileName(i) << endl;
+            return 1;
+        }
+        frames.push_back(img);
+    }
+
+    // AKAZE descriptors need AKAZE keypoints and SIFT is described on its own octaves, the others take FAST corners
+    // the last ORB row describes on the levels of the frame pyramid instead of a crop
+    const DescriptorKind descriptors[] = {DescriptorKind::BRISK, DescriptorKind::BRIEF, DescriptorKind::ORB, DescriptorKind::FREAK,
+                                          DescriptorKind::AKAZE, DescriptorKind::SIFT, DescriptorKind::ORB};
+    const DetectorKind detectors[] = {DetectorKind::BRISK, DetectorKind::FAST, DetectorKind::ORB, DetectorKind::FAST,
+                                      DetectorKind::AKAZE, DetectorKind::SIFT, DetectorKind::ORB};
+    const size_t numCombinations = sizeof(descriptors) / sizeof(descriptors[0]);
+    bool bSame = true;
+    cout << setw(10) << "descriptor" << setw(10) << "detector" << setw(9) << "source" << setw(11) << "keypoints" << setw(13)
+         << "crop area" << setw(12) << "differing" << setw(14) << "max distance" << endl;
+    for (size_t d = 0; d < numCombinations; ++d)
+    {
+        const bool bPyramid = d + 1 == numCombinations;
+        cv::Ptr<cv::DescriptorExtractor> extractor = AlgorithmRegistry::instance().extractor(descriptors[d]);
+        const bool bBinary = descriptors[d] != DescriptorKind::SIFT;
+        size_t numKeypoints = 0, numDiffering = 0;
+        double cropArea = 0.0, maxDistance = 0.0;
+        bool bSameKeypoints = true;
+        for (cv::Mat &img : frames)
+        {
+            vector<cv::KeyPoint> keypoints;
+            detKeypointsRoi(keypoints, img, config.rois, detectors[d]);
+            vector<cv::KeyPoint> fullKeypoints = keypoints;
+
+            cv::Mat cropDescriptors, fullDescriptors;
+            if (bPyramid)
+            { // the pyramid of the tracker, which covers the whole frame also with ROIs
+                DataFrame frame;
+                frame.cameraImg = img;
+                buildFramePyramid(frame, cv::Rect(0, 0, img.cols, img.rows), ORB_PYRAMID);
+                descKeypointsOrbPyramid(keypoints, frame, cropDescriptors);
+            }
+            else
+            {
+                cropArea += descriptorSupportRect(keypoints, img.size(), descriptors[d]).area() / (double)img.total();
+                descKeypoints(keypoints, img, cropDescriptors, descriptors[d]);
+            }
+            extractor->compute(img, fullKeypoints, fullDescriptors);
+
+            // the extractor removes keypoints too close to the border, the same ones with and without the crop
+            if (keypoints.size() != fullKeypoints.size() || cropDescriptors.rows != fullDescriptors.rows)
+            {
+                bSameKeypoints = false;
+                continue;
+            }
+            for (size_t i = 0; i < keypoints.size(); ++i)
+            {
+                bSameKeypoints = bSameKeypoints && sameKeypoint(keypoints[i], fullKeypoints[i]);
+                const cv::Mat a = cropDescriptors.row(i), b = fullDescriptors.row(i);
+                double distance = bBinary ? cv::norm(a, b, cv::NORM_HAMMING) : cv::norm(a, b, cv::NORM_L2) / max(cv::norm(b, cv::NORM_L2), 1.0);
+                maxDistance = max(maxDistance, distance);
+                numDiffering += distance > 0.0 ? 1 : 0;
+            }
+            numKeypoints += keypoints.size();
+        }
+
+        bool bOk = bSameKeypoints && (bBinary ? maxDistance == 0.0 : maxDistance <= MAX_RELATIVE_L2);
+        bSame &= bOk;
+        ostringstream area; // each level of the pyramid is cropped on its own
+        area << fixed << setprecision(1) << 100.0 * cropArea / frames.size() << "%";
+        cout << setw(10) << toString(descriptors[d]) << setw(10) << toString(detectors[d]) << setw(9) << (bPyramid ? "pyramid" : "crop")
+             << setw(11) << numKeypoints << setw(13) << (bPyramid ? "-" : area.str()) << setw(12) << numDiffering << setw(14)
+             << fixed << setprecision(5) << maxDistance << (bSameKeypoints ? "" : "  KEYPOINTS DIFFER") << (bOk ? "" : "  MISMATCH") << endl;
+    }
+    return bSame ? 0 : 1;
+}
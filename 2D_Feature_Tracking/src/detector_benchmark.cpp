@@ -0,0 +1,174 @@
+// tiled detection (detKeypointsTiled) against detection in one piece, on the KITTI frames of the tracker, for every
+// detector on the whole image and on the vehicle ROI of the default configuration, with pools of 1, 2, 4 and 8 threads
+// the keypoints of every pool size are compared with those of the single thread, they must not change, and with those
+// of the detection in one piece : the share of its keypoints which tiling finds, and of tiled ones which it finds
+// usage : detector_benchmark [repetitions] [data directory which contains images/, default ../]
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <functional>
+#include <cstdlib>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include "matching2D.hpp"
+#include "tracker.hpp"
+#include "imageSource.hpp"
+#include "threadPool.hpp"
+#include "keypointGrid.hpp"
+
+using namespace std;
+
+typedef function<void(cv::Mat &img, vector<cv::KeyPoint> &keypoints)> DetectFunction;
+
+static const float MATCH_DISTANCE = 1.0f; // keypoints this close are the same one, refined to slightly different positions
+
+// average time per frame in [s] and average no. of keypoints per frame, results holds the keypoints of every frame
+static double timeDetection(const DetectFunction &detect, vector<cv::Mat> &frames, int repetitions, size_t &numKeypoints,
+                            vector<vector<cv::KeyPoint> > &results)
+{
+    results.assign(frames.size(), vector<cv::KeyPoint>());
+    double t = (double)cv::getTickCount();
+    for (int r = 0; r < repetitions; ++r)
+    {
+        for (size_t f = 0; f < frames.size(); ++f)
+        {
+            detect(frames[f], results[f]);
+        }
+    }
+    t = ((double)cv::getTickCount() - t) / cv::getTickFrequency() / (repetitions * frames.size());
+    numKeypoints = 0;
+    for (const auto &keypoints : results)
+    {
+        numKeypoints += keypoints.size();
+    }
+    numKeypoints /= max<size_t>(frames.size(), 1);
+    return t;
+}
+
+static bool sameKeypoints(const vector<vector<cv::KeyPoint> > &a, const vector<vector<cv::KeyPoint> > &b)
+{
+    for (size_t f = 0; f < a.size(); ++f)
+    {
+        if (a[f].size() != b[f].size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < a[f].size(); ++i)
+        {
+            const cv::KeyPoint &p = a[f][i], &q = b[f][i];
+            if (p.pt != q.pt || p.size != q.size || p.response != q.response || p.octave != q.octave)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// share of the keypoints of a which have a keypoint of b closer than MATCH_DISTANCE in the same frame
+static double foundShare(const vector<vector<cv::KeyPoint> > &a, const vector<vector<cv::KeyPoint> > &b)
+{
+    size_t numFound = 0, numKeypoints = 0;
+    for (size_t f = 0; f < a.size(); ++f)
+    {
+        const KeypointGrid grid(b[f], MATCH_DISTANCE);
+        for (const cv::KeyPoint &kpt : a[f])
+        {
+            bool bFound = false;
+            grid.forEachNear(kpt.pt, MATCH_DISTANCE, [&](int j) {
+                cv::Point2f d = kpt.pt - b[f][j].pt;
+                bFound = bFound || d.dot(d) < MATCH_DISTANCE * MATCH_DISTANCE;
+            });
+            numFound += bFound ? 1 : 0;
+        }
+        numKeypoints += a[f].size();
+    }
+    return numKeypoints > 0 ? (double)numFound / numKeypoints : 1.0;
+}
+
+int main(int argc, const char *argv[])
+{
+    int repetitions = argc > 1 ? atoi(argv[1]) : 3;
+    TrackerConfig config;
+    if (argc > 2)
+    {
+        config.imgBasePath = string(argv[2]) + "/images/";
+    }
+
+    vector<cv::Mat> frames;
+    ImageSequence sequence = imageSequence(config);
+    for (size_t i = 0; i < sequence.size(); ++i)
+    {
+        cv::Mat img = cv::imread(sequence.fileName(i), cv::IMREAD_GRAYSCALE);
+        if (img.empty())
+        {
+            cerr << "could not read " << sequence.fileName(i) << endl;
+            return 1;
+        }
+        frames.push_back(img);
+    }
+    cout << frames.size() << " frames, " << repetitions << " repetitions, " << ThreadPool::shared().size() << " hardware threads" << endl;
+    cout << setw(10) << "detector" << setw(8) << "region" << setw(9) << "threads" << setw(12) << "time [ms]" << setw(10) << "speedup"
+         << setw(11) << "keypoints" << setw(10) << "found [%]" << setw(10) << "kept [%]" << endl;
+    cout << "found : keypoints of the detection in one piece which tiling finds, kept : tiled keypoints which it finds" << endl;
+
+    const DetectorKind detectors[] = {DetectorKind::SHITOMASI, DetectorKind::HARRIS, DetectorKind::FAST, DetectorKind::BRISK,
+                                      DetectorKind::ORB, DetectorKind::AKAZE, DetectorKind::SIFT};
+    const vector<DetectionRoi> wholeImage;
+    const vector<DetectionRoi> *regions[] = {&wholeImage, &config.rois};
+    bool bSame = true;
+    for (DetectorKind detectorKind : detectors)
+    {
+        for (const vector<DetectionRoi> *rois : regions)
+        {
+            const char *regionName = rois->empty() ? "image" : "ROI";
+            vector<vector<cv::KeyPoint> > untiled, reference, results;
+            size_t numKeypoints;
+
+            // detection in one piece as in the tracking stages, the first call builds the detector outside of the timing
+            DetectFunction single = [&](cv::Mat &img, vector<cv::KeyPoint> &keypoints) {
+                keypoints.clear();
+                if (!rois->empty())
+                {
+                    detKeypointsRoi(keypoints, img, *rois, detectorKind);
+                }
+                else if (detectorKind == DetectorKind::SHITOMASI)
+                {
+                    detKeypointsShiTomasi(keypoints, img);
+                }
+                else if (detectorKind == DetectorKind::HARRIS)
+                {
+                    detKeypointsHarris(keypoints, img);
+                }
+                else
+                {
+                    detKeypointsModern(keypoints, img, detectorKind);
+                }
+            };
+            timeDetection(single, frames, 1, numKeypoints, results);
+            double tSingle = timeDetection(single, frames, repetitions, numKeypoints, untiled);
+            cout << setw(10) << toString(detectorKind) << setw(8) << regionName << setw(9) << "-" << setw(12) << 1000 * tSingle
+                 << setw(10) << 1.0 << setw(11) << numKeypoints << setw(10) << "-" << setw(10) << "-" << endl;
+
+            for (int numThreads : {1, 2, 4, 8})
+            {
+                ThreadPool pool(numThreads);
+                DetectFunction tiled = [&](cv::Mat &img, vector<cv::KeyPoint> &keypoints) {
+                    detKeypointsTiled(keypoints, img, *rois, detectorKind, &pool);
+                };
+                double t = timeDetection(tiled, frames, repetitions, numKeypoints, results);
+                if (numThreads == 1)
+                {
+                    reference = results;
+                }
+                bool bSameThreads = sameKeypoints(reference, results);
+                bSame &= bSameThreads;
+                cout << setw(10) << toString(detectorKind) << setw(8) << regionName << setw(9) << numThreads << setw(12) << 1000 * t
+                     << setw(10) << tSingle / t << setw(11) << numKeypoints << setw(10) << 100.0 * foundShare(untiled, results)
+                     << setw(10) << 100.0 * foundShare(results, untiled) << (bSameThreads ? "" : "  MISMATCH") << endl;
+            }
+        }
+    }
+    return bSame ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+#include <stdexcept>
+#include "featureTypes.hpp"
+
+using namespace std;
+
+static const char *detectorNames[NUM_DETECTOR_KINDS] = {"SHITOMASI", "HARRIS", "FAST", "BRISK", "ORB", "AKAZE", "SIFT"};
+static const char *descriptorNames[NUM_DESCRIPTOR_KINDS] = {"BRISK", "BRIEF", "ORB", "FREAK", "AKAZE", "SIFT"};
+static const char *descriptorDataNames[2] = {"DES_BINARY", "DES_HOG"};
+static const char *matcherNames[NUM_MATCHER_KINDS] = {"MAT_BF", "MAT_FLANN", "MAT_GUIDED"};
+static const char *selectorNames[NUM_SELECTOR_KINDS] = {"SEL_NN", "SEL_KNN", "SEL_MUTUAL", "SEL_MUTUAL_KNN"};
+static const char *retentionNames[NUM_RETENTION_KINDS] = {"RET_BEST", "RET_GRID", "RET_SSC"};
+
+// index of name in names, throws if it is not part of the list
+template <typename Kind, int N>
+static Kind parseKind(const char *(&names)[N], const string &name, const char *what)
+{
+    for (int i = 0; i < N; ++i)
+    {
+        if (!name.compare(names[i]))
+        {
+            return static_cast<Kind>(i);
+        }
+    }
+    throw invalid_argument(string("invalid ") + what + " " + name);
+}
+
+DetectorKind parseDetectorKind(const string &name) { return parseKind<DetectorKind>(detectorNames, name, "detectorType"); }
+DescriptorKind parseDescriptorKind(const string &name) { return parseKind<DescriptorKind>(descriptorNames, name, "descriptorType"); }
+DescriptorDataKind parseDescriptorDataKind(const string &name) { return parseKind<DescriptorDataKind>(descriptorDataNames, name, "descriptorType"); }
+MatcherKind parseMatcherKind(const string &name) { return parseKind<MatcherKind>(matcherNames, name, "matcherType"); }
+SelectorKind parseSelectorKind(const string &name) { return parseKind<SelectorKind>(selectorNames, name, "selectorType"); }
+RetentionKind parseRetentionKind(const string &name) { return parseKind<RetentionKind>(retentionNames, name, "retentionType"); }
+
+const char *toString(DetectorKind kind) { return detectorNames[static_cast<int>(kind)]; }
+const char *toString(DescriptorKind kind) { return descriptorNames[static_cast<int>(kind)]; }
+const char *toString(DescriptorDataKind kind) { return descriptorDataNames[static_cast<int>(kind)]; }
+const char *toString(MatcherKind kind) { return matcherNames[static_cast<int>(kind)]; }
+const char *toString(SelectorKind kind) { return selectorNames[static_cast<int>(kind)]; }
+const char *toString(RetentionKind kind) { return retentionNames[static_cast<int>(kind)]; }
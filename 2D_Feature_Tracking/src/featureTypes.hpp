@@ -0,0 +1,73 @@
+#ifndef featureTypes_hpp
+#define featureTypes_hpp
+
+#include <string>
+
+
+// algorithm selections of the tracker, parsed once at startup instead of being compared as strings per frame
+enum class DetectorKind { SHITOMASI, HARRIS, FAST, BRISK, ORB, AKAZE, SIFT };
+enum class DescriptorKind { BRISK, BRIEF, ORB, FREAK, AKAZE, SIFT };
+enum class DescriptorDataKind { DES_BINARY, DES_HOG };
+enum class MatcherKind { MAT_BF, MAT_FLANN, MAT_GUIDED }; // MAT_GUIDED only compares keypoints near their predicted position
+enum class SelectorKind { SEL_NN, SEL_KNN, SEL_MUTUAL, SEL_MUTUAL_KNN }; // SEL_MUTUAL* keep mutual nearest neighbors only
+enum class RetentionKind { RET_BEST, RET_GRID, RET_SSC }; // which keypoints a budget keeps, see retainKeypoints
+
+const int NUM_DETECTOR_KINDS = 7;
+const int NUM_DESCRIPTOR_KINDS = 6;
+const int NUM_MATCHER_KINDS = 3;
+const int NUM_SELECTOR_KINDS = 4;
+const int NUM_RETENTION_KINDS = 3;
+
+// SIFT produces floating point (histogram of gradients) descriptors, all others are binary strings
+constexpr DescriptorDataKind descriptorDataKindOf(DescriptorKind descriptor)
+{
+    return descriptor == DescriptorKind::SIFT ? DescriptorDataKind::DES_HOG : DescriptorDataKind::DES_BINARY;
+}
+
+// SEL_KNN and SEL_MUTUAL_KNN drop ambiguous matches with the distance ratio test
+constexpr bool usesRatioTest(SelectorKind selector)
+{
+    return selector == SelectorKind::SEL_KNN || selector == SelectorKind::SEL_MUTUAL_KNN;
+}
+
+// SEL_MUTUAL and SEL_MUTUAL_KNN keep a match only if the source keypoint is also the best match of its reference keypoint
+constexpr bool isMutual(SelectorKind selector)
+{
+    return selector == SelectorKind::SEL_MUTUAL || selector == SelectorKind::SEL_MUTUAL_KNN;
+}
+
+// false for detector / descriptor pairs which OpenCV cannot process :
+// AKAZE descriptors need the scale-space information stored in AKAZE keypoints and
+// ORB cannot describe SIFT keypoints, their octave field does not index an ORB pyramid level
+constexpr bool isValidCombination(DetectorKind detector, DescriptorKind descriptor)
+{
+    return !(descriptor == DescriptorKind::AKAZE && detector != DetectorKind::AKAZE) &&
+           !(detector == DetectorKind::SIFT && descriptor == DescriptorKind::ORB);
+}
+
+// detector and descriptor are the same OpenCV algorithm with the same parameters, so a single detectAndCompute call
+// builds the scale space once for both
+constexpr bool isFusedCombination(DetectorKind detector, DescriptorKind descriptor)
+{
+    return (detector == DetectorKind::BRISK && descriptor == DescriptorKind::BRISK) ||
+           (detector == DetectorKind::ORB && descriptor == DescriptorKind::ORB) ||
+           (detector == DetectorKind::AKAZE && descriptor == DescriptorKind::AKAZE) ||
+           (detector == DetectorKind::SIFT && descriptor == DescriptorKind::SIFT);
+}
+
+// conversion from and to the names used on the command line, parsing throws invalid_argument for unknown names
+DetectorKind parseDetectorKind(const std::string &name);
+DescriptorKind parseDescriptorKind(const std::string &name);
+DescriptorDataKind parseDescriptorDataKind(const std::string &name);
+MatcherKind parseMatcherKind(const std::string &name);
+SelectorKind parseSelectorKind(const std::string &name);
+RetentionKind parseRetentionKind(const std::string &name);
+
+const char *toString(DetectorKind kind);
+const char *toString(DescriptorKind kind);
+const char *toString(DescriptorDataKind kind);
+const char *toString(MatcherKind kind);
+const char *toString(SelectorKind kind);
+const char *toString(RetentionKind kind);
+
+#endif /* featureTypes_hpp */
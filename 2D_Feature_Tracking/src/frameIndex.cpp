@@ -0,0 +1,361 @@
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "frameIndex.hpp"
+#include "metrics.hpp"
+#include "threadPool.hpp"
+
+using namespace std;
+
+struct IndexFileHeader { // first bytes of an index file, stored in host byte order
+    char magic[8];        // "DESCIDX1"
+    uint32_t dataKind;    // DescriptorDataKind of the indexed descriptors
+    uint32_t rows;        // no. of descriptors
+    uint32_t cols;        // descriptor length in elements
+    uint32_t type;        // OpenCV type of the descriptors
+    uint64_t hash;        // FNV-1a of the descriptor bytes, detects an index saved for other descriptors
+};
+
+static const char INDEX_FILE_MAGIC[8] = {'D', 'E', 'S', 'C', 'I', 'D', 'X', '1'};
+static const int KD_TREES = 4;         // as cv::FlannBasedMatcher
+static const int KD_CHECKS = 32;
+static const int QUERY_CHUNK_ROWS = 64; // queries per task on the thread pool
+
+static uint64_t descriptorHash(const cv::Mat &descriptors)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (int r = 0; r < descriptors.rows; ++r)
+    {
+        const uchar *p = descriptors.ptr(r);
+        for (size_t i = 0; i < descriptors.cols * descriptors.elemSize(); ++i)
+        {
+            hash = (hash ^ p[i]) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+static IndexFileHeader indexFileHeader(const cv::Mat &descriptors, DescriptorDataKind descriptorDataKind)
+{
+    IndexFileHeader header;
+    memcpy(header.magic, INDEX_FILE_MAGIC, sizeof(header.magic));
+    header.dataKind = static_cast<uint32_t>(descriptorDataKind);
+    header.rows = descriptors.rows;
+    header.cols = descriptors.cols;
+    header.type = descriptors.type();
+    header.hash = descriptorHash(descriptors);
+    return header;
+}
+
+DescriptorIndex::DescriptorIndex() : descriptorDataKind(DescriptorDataKind::DES_BINARY)
+{
+}
+
+void DescriptorIndex::build(const cv::Mat &descriptors, DescriptorDataKind descriptorDataKind)
+{
+    this->descriptorDataKind = descriptorDataKind;
+    this->descriptors = descriptors.clone();
+    kdTree.reset();
+    if (descriptorDataKind == DescriptorDataKind::DES_BINARY)
+    {
+        mih.build(this->descriptors);
+    }
+    else if (!this->descriptors.empty())
+    {
+        kdTree = cv::makePtr<cv::flann::Index>(this->descriptors, cv::flann::KDTreeIndexParams(KD_TREES));
+    }
+}
+
+void DescriptorIndex::knnMatch(const cv::Mat &queries, int k, vector<vector<cv::DMatch> > &matches) const
+{
+    if (descriptorDataKind == DescriptorDataKind::DES_BINARY)
+    {
+        mih.knnMatch(queries, k, matches, &ThreadPool::shared());
+        return;
+    }
+
+    matches.assign(queries.rows, vector<cv::DMatch>());
+    if (queries.empty() || !kdTree)
+    {
+        return;
+    }
+    if (queries.type() != descriptors.type() || queries.cols != descriptors.cols)
+    {
+        throw invalid_argument("DescriptorIndex : queries differ in type or length from the indexed descriptors");
+    }
+
+    // searches only read the tree, so chunks of queries run in parallel
+    k = min(k, descriptors.rows);
+    ThreadPool::shared().parallelFor((queries.rows + QUERY_CHUNK_ROWS - 1) / QUERY_CHUNK_ROWS, [&](int chunk) {
+        int first = chunk * QUERY_CHUNK_ROWS;
+        cv::Mat indices, dists;
+        kdTree->knnSearch(queries.rowRange(first, min(queries.rows, first + QUERY_CHUNK_ROWS)), indices, dists, k,
+                          cv::flann::SearchParams(KD_CHECKS));
+        for (int i = 0; i < indices.rows; ++i)
+        {
+            for (int j = 0; j < k; ++j)
+            { // FLANN returns squared L2 distances
+                int idx = indices.at<int>(i, j);
+                if (idx >= 0)
+                {
+                    matches[first + i].push_back(cv::DMatch(first + i, idx, sqrt(dists.at<float>(i, j))));
+                }
+            }
+        }
+    });
+}
+
+void DescriptorIndex::match(const cv::Mat &queries, double maxRatio, vector<cv::DMatch> &matches) const
+{
+    if (descriptorDataKind == DescriptorDataKind::DES_BINARY)
+    { // the ratio test often ends the search long before the second neighbor is known
+        mih.match(queries, maxRatio, matches, &ThreadPool::shared());
+        return;
+    }
+
+    bool bRatio = maxRatio > 0;
+    vector<vector<cv::DMatch> > kmatches;
+    knnMatch(queries, bRatio ? 2 : 1, kmatches);
+    matches.clear();
+    for (const auto &kmatch : kmatches)
+    {
+        if (!bRatio)
+        { // nearest neighbor (best match)
+            if (!kmatch.empty())
+            {
+                matches.push_back(kmatch[0]);
+            }
+        }
+        else if (kmatch.size() == 2 && kmatch[0].distance < maxRatio * kmatch[1].distance)
+        { // k nearest neighbors (k=2)
+            matches.push_back(kmatch[0]);
+        }
+    }
+}
+
+// moves a completely written file into place, so a reader never sees a partial file under fileName
+static void renameIntoPlace(const string &tmpName, const string &fileName)
+{
+    if (rename(tmpName.c_str(), fileName.c_str()) != 0)
+    {
+        unlink(tmpName.c_str());
+        throw runtime_error("could not write " + fileName + " : " + strerror(errno));
+    }
+}
+
+void DescriptorIndex::save(const string &fileName) const
+{
+    // temporary names of this process, other jobs of a sweep may write the same index at the same time
+    const string tmpSuffix = "." + to_string(getpid()) + ".tmp";
+    if (descriptorDataKind == DescriptorDataKind::DES_HOG && kdTree)
+    { // the kd-tree goes first, an index file is only renamed into place once its tree is there
+        const string flannName = fileName + ".flann", tmpName = flannName + tmpSuffix;
+        try
+        {
+            kdTree->save(tmpName);
+        }
+        catch (const cv::Exception &e)
+        {
+            unlink(tmpName.c_str());
+            throw runtime_error("could not write " + flannName + " : " + e.what());
+        }
+        struct stat fileStat;
+        if (stat(tmpName.c_str(), &fileStat) != 0 || fileStat.st_size == 0)
+        { // FLANN does not report failed writes
+            unlink(tmpName.c_str());
+            throw runtime_error("could not write " + flannName);
+        }
+        renameIntoPlace(tmpName, flannName);
+    }
+
+    const string tmpName = fileName + tmpSuffix;
+    ofstream out(tmpName, ios::binary);
+    if (!out)
+    {
+        throw runtime_error("could not open " + tmpName);
+    }
+    IndexFileHeader header = indexFileHeader(descriptors, descriptorDataKind);
+    out.write((const char *)&header, sizeof(header));
+    if (descriptorDataKind == DescriptorDataKind::DES_BINARY)
+    {
+        mih.write(out);
+    }
+    out.close();
+    if (!out)
+    {
+        unlink(tmpName.c_str());
+        throw runtime_error("could not write " + fileName);
+    }
+    renameIntoPlace(tmpName, fileName);
+}
+
+bool DescriptorIndex::load(const string &fileName, const cv::Mat &descriptors, DescriptorDataKind descriptorDataKind)
+{
+    ifstream in(fileName, ios::binary);
+    IndexFileHeader header, expected = indexFileHeader(descriptors, descriptorDataKind);
+    if (!in || !in.read((char *)&header, sizeof(header)) || memcmp(&header, &expected, sizeof(header)) != 0)
+    {
+        return false;
+    }
+
+    this->descriptorDataKind = descriptorDataKind;
+    this->descriptors = descriptors.clone();
+    kdTree.reset();
+    try
+    {
+        if (descriptorDataKind == DescriptorDataKind::DES_BINARY)
+        {
+            mih.read(in, this->descriptors);
+        }
+        else if (!this->descriptors.empty())
+        {
+            kdTree = cv::makePtr<cv::flann::Index>();
+            if (!kdTree->load(this->descriptors, fileName + ".flann"))
+            {
+                kdTree.reset();
+                return false;
+            }
+        }
+    }
+    catch (const exception &)
+    { // a truncated or corrupt table behind a valid header, the caller builds the index again
+        kdTree.reset();
+        return false;
+    }
+    return true;
+}
+
+void matchIndexed(const cv::Mat &descSource, const DescriptorIndex &refIndex, const cv::Mat &descRef, const DescriptorIndex *sourceIndex,
+                  bool bRatio, vector<cv::DMatch> &matches)
+{
+    double minDistanceRatio = 0.8;
+    vector<cv::DMatch> found;
+    refIndex.match(descSource, bRatio ? minDistanceRatio : 0.0, found);
+    size_t firstMatch = matches.size();
+    matches.insert(matches.end(), found.begin(), found.end());
+
+    if (sourceIndex)
+    { // an index has no column-wise result, so the reference descriptors are searched in the index of the source ones
+        vector<cv::DMatch> reverse;
+        sourceIndex->match(descRef, 0.0, reverse);
+        vector<int> bestSource(descRef.rows, -1);
+        for (const auto &m : reverse)
+        {
+            bestSource[m.queryIdx] = m.trainIdx;
+        }
+        auto end = remove_if(matches.begin() + firstMatch, matches.end(),
+                             [&](const cv::DMatch &m) { return bestSource[m.trainIdx] != m.queryIdx; });
+        matches.erase(end, matches.end());
+    }
+}
+
+// creates dirName and its missing parents, throws runtime_error if it cannot be created or written to
+static void createIndexDirectory(const string &dirName)
+{
+    for (size_t end = dirName.find('/', 1); ; end = dirName.find('/', end + 1))
+    {
+        string prefix = dirName.substr(0, end);
+        if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST)
+        {
+            throw runtime_error("could not create index directory " + prefix + " : " + strerror(errno));
+        }
+        if (end == string::npos)
+        {
+            break;
+        }
+    }
+
+    struct stat dirStat;
+    if (stat(dirName.c_str(), &dirStat) != 0 || !S_ISDIR(dirStat.st_mode) || access(dirName.c_str(), W_OK | X_OK) != 0)
+    {
+        throw runtime_error("index directory " + dirName + " is not a writable directory");
+    }
+}
+
+FrameIndexMatcher::FrameIndexMatcher(const string &indexDir, const string &indexName)
+    : indexDir(indexDir), indexName(indexName), bSaveIndices(!indexDir.empty()), builds(0), loads(0), reuses(0)
+{
+    if (!indexDir.empty())
+    { // fail at the start of a run rather than at the first saved index
+        createIndexDirectory(indexDir);
+    }
+}
+
+const DescriptorIndex &FrameIndexMatcher::index(DataFrame &frame, DescriptorDataKind descriptorDataKind)
+{
+    if (frame.descIndex)
+    {
+        ++reuses;
+        return *frame.descIndex;
+    }
+
+    ScopedTimer timer("index", toString(descriptorDataKind));
+    shared_ptr<DescriptorIndex> index = make_shared<DescriptorIndex>();
+    string fileName;
+    if (!indexDir.empty())
+    {
+        ostringstream name;
+        name << indexDir << "/" << indexName << (indexName.empty() ? "" : "_") << "frame" << setfill('0') << setw(6) << frame.stats.frameIndex << ".idx";
+        fileName = name.str();
+    }
+
+    if (!fileName.empty() && index->load(fileName, frame.descriptors, descriptorDataKind))
+    {
+        ++loads;
+    }
+    else
+    {
+        index->build(frame.descriptors, descriptorDataKind);
+        ++builds;
+        if (bSaveIndices)
+        {
+            try
+            {
+                index->save(fileName);
+            }
+            catch (const runtime_error &re)
+            { // e.g. a full disk, the index in memory serves this run and later runs build it again
+                cerr << "warning : " << re.what() << ", no further indices are saved" << endl;
+                bSaveIndices = false;
+            }
+        }
+    }
+    frame.descIndex = index;
+    return *index;
+}
+
+void FrameIndexMatcher::match(DataFrame &prevFrame, DataFrame &frame, DescriptorDataKind descriptorDataKind, SelectorKind selectorKind)
+{
+    if (prevFrame.descriptors.empty() || frame.descriptors.empty())
+    { // nothing to match, e.g. no keypoints left in the ROI
+        return;
+    }
+    ScopedTimer timer("matcher", toString(MatcherKind::MAT_FLANN));
+    const DescriptorIndex &refIndex = index(frame, descriptorDataKind);
+    const DescriptorIndex *sourceIndex = isMutual(selectorKind) ? &index(prevFrame, descriptorDataKind) : NULL;
+    matchIndexed(prevFrame.descriptors, refIndex, frame.descriptors, sourceIndex, usesRatioTest(selectorKind), frame.kptMatches);
+}
+
+FrameIndexStats FrameIndexMatcher::stats() const
+{
+    FrameIndexStats s;
+    s.builds = builds;
+    s.loads = loads;
+    s.reuses = reuses;
+    return s;
+}
+
+void FrameIndexMatcher::printStats(ostream &os) const
+{
+    FrameIndexStats s = stats();
+    os << "frame indices : " << s.builds << " built, " << s.loads << " loaded, " << s.reuses << " reused" << endl;
+}
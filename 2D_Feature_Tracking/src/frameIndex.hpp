@@ -0,0 +1,89 @@
+#ifndef frameIndex_hpp
+#define frameIndex_hpp
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/flann.hpp>
+
+#include "dataStructures.h"
+#include "featureTypes.hpp"
+#include "mihIndex.hpp"
+
+
+// search index over the descriptors of one frame : exact multi-index hashing for binary descriptors,
+// a FLANN kd-tree forest (as cv::FlannBasedMatcher) for floating point descriptors
+// it is built once and may then be searched by any no. of later queries, also from several threads at the same time
+class DescriptorIndex
+{
+public:
+    DescriptorIndex();
+
+    void build(const cv::Mat &descriptors, DescriptorDataKind descriptorDataKind);
+
+    // k nearest neighbors of every query row, sorted by distance, chunks of queries are searched on the shared thread pool
+    void knnMatch(const cv::Mat &queries, int k, std::vector<std::vector<cv::DMatch> > &matches) const;
+
+    // nearest neighbor of every query, with maxRatio > 0 only of the queries which pass best < maxRatio * second best
+    void match(const cv::Mat &queries, double maxRatio, std::vector<cv::DMatch> &matches) const;
+
+    // writes the index to fileName, the kd-tree of floating point descriptors to fileName + ".flann", throws runtime_error
+    // both are written to temporary files first and renamed into place, so a crash never leaves a partial index behind
+    void save(const std::string &fileName) const;
+
+    // index saved for exactly these descriptors, returns false if there is no such file, it was saved for other descriptors
+    // or it cannot be read
+    bool load(const std::string &fileName, const cv::Mat &descriptors, DescriptorDataKind descriptorDataKind);
+
+    int size() const { return descriptors.rows; }
+
+private:
+    DescriptorDataKind descriptorDataKind;
+    cv::Mat descriptors;                // copy of the indexed descriptors, the kd-tree points into it
+    MihIndex mih;                       // DES_BINARY
+    cv::Ptr<cv::flann::Index> kdTree;   // DES_HOG
+};
+
+// matches of every source descriptor in the index of the reference descriptors, with the ratio test if bRatio,
+// and cross-checked against the index of the source descriptors if sourceIndex is given
+void matchIndexed(const cv::Mat &descSource, const DescriptorIndex &refIndex, const cv::Mat &descRef, const DescriptorIndex *sourceIndex,
+                  bool bRatio, std::vector<cv::DMatch> &matches);
+
+
+struct FrameIndexStats {
+    uint64_t builds;  // no. of indices built from the descriptors
+    uint64_t loads;   // no. of indices read from the index directory instead
+    uint64_t reuses;  // no. of searches in an index which already existed
+};
+
+// owns the search indices of the frames in the ring buffer : the index of a frame is attached to its DataFrame
+// the first time the frame is searched and then reused by every later query, e.g. the reverse search of the
+// mutual selectors one frame later, until the slot of the frame is overwritten
+// with an index directory, indices are saved per frame and a later run over the same recording loads them, the file names
+// hold indexName so the combinations of a sweep do not overwrite each other's indices
+class FrameIndexMatcher
+{
+public:
+    // creates indexDir if it does not exist, throws runtime_error if it cannot be created or written to
+    // a later failed save only prints a warning and stops saving, the indices in memory are still used
+    explicit FrameIndexMatcher(const std::string &indexDir = "", const std::string &indexName = "");
+
+    // index of the frame descriptors, frames must only be searched from the thread which runs the match stage
+    const DescriptorIndex &index(DataFrame &frame, DescriptorDataKind descriptorDataKind);
+
+    // matches of prevFrame in the index of frame, with the mutual selectors also searching the index of prevFrame
+    void match(DataFrame &prevFrame, DataFrame &frame, DescriptorDataKind descriptorDataKind, SelectorKind selectorKind);
+
+    FrameIndexStats stats() const;
+    void printStats(std::ostream &os) const;
+
+private:
+    std::string indexDir;
+    std::string indexName; // e.g. detector and descriptor which computed the descriptors
+    bool bSaveIndices;
+    uint64_t builds, loads, reuses;
+};
+
+#endif /* frameIndex_hpp */
@@ -0,0 +1,154 @@
+#include <cstring>
+#include <limits>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <opencv2/imgcodecs.hpp>
+
+#include "framePack.hpp"
+
+using namespace std;
+
+static const char FRAME_PACK_MAGIC[8] = {'F', 'R', 'M', 'P', 'A', 'C', 'K', '1'};
+static const uint64_t FRAME_PACK_ALIGNMENT = 4096; // page size, frames start on page boundaries
+
+static uint64_t alignUp(uint64_t value)
+{
+    return (value + FRAME_PACK_ALIGNMENT - 1) / FRAME_PACK_ALIGNMENT * FRAME_PACK_ALIGNMENT;
+}
+
+// product of a and b, false if it does not fit into 64 bits
+static bool multiply(uint64_t a, uint64_t b, uint64_t &product)
+{
+    if (a != 0 && b > UINT64_MAX / a)
+    {
+        return false;
+    }
+    product = a * b;
+    return true;
+}
+
+// a corrupt header must not let frame() return images which reach beyond the mapping
+static bool validHeader(const FramePackHeader &header, uint64_t fileSize)
+{
+    if (memcmp(header.magic, FRAME_PACK_MAGIC, sizeof(header.magic)) != 0)
+    {
+        return false;
+    }
+
+    // cv::Mat takes int dimensions, and an image type is interleaved with one to four channels
+    const uint32_t maxSide = numeric_limits<int>::max();
+    if (header.width == 0 || header.height == 0 || header.width > maxSide || header.height > maxSide ||
+        header.type > CV_MAT_TYPE_MASK || CV_MAT_DEPTH(header.type) > CV_64F || CV_MAT_CN(header.type) > 4)
+    {
+        return false;
+    }
+
+    uint64_t pixels, frameSize, dataSize;
+    return multiply(header.width, header.height, pixels) && multiply(pixels, CV_ELEM_SIZE(header.type), frameSize) &&
+           header.frameStride >= frameSize && multiply(header.frameCount, header.frameStride, dataSize) &&
+           header.dataOffset >= sizeof(FramePackHeader) && header.dataOffset <= fileSize && dataSize <= fileSize - header.dataOffset;
+}
+
+void writeFramePack(const ImageSequence &sequence, const string &fileName, bool bColor)
+{
+    if (sequence.size() == 0)
+    { // the header is written with the first frame, a pack without frames would have none
+        throw runtime_error("no images to write to frame pack " + fileName);
+    }
+
+    ofstream out(fileName, ios::binary);
+    if (!out)
+    {
+        throw runtime_error("could not open " + fileName);
+    }
+
+    FramePackHeader header;
+    memcpy(header.magic, FRAME_PACK_MAGIC, sizeof(header.magic));
+    header.frameCount = sequence.size();
+    header.dataOffset = alignUp(sizeof(FramePackHeader));
+
+    vector<char> padding(FRAME_PACK_ALIGNMENT, 0);
+    for (size_t i = 0; i < sequence.size(); ++i)
+    {
+        string imgFullFilename = sequence.fileName(i);
+        cv::Mat img = cv::imread(imgFullFilename, bColor ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE);
+        if (img.empty())
+        {
+            throw runtime_error("could not read image " + imgFullFilename);
+        }
+
+        if (i == 0)
+        { // the first frame determines the layout of the pack
+            header.width = img.cols;
+            header.height = img.rows;
+            header.type = img.type();
+            header.frameStride = alignUp((uint64_t)img.cols * img.rows * img.elemSize());
+            out.write((const char *)&header, sizeof(header));
+            out.write(padding.data(), header.dataOffset - sizeof(header));
+        }
+        else if (img.cols != (int)header.width || img.rows != (int)header.height || img.type() != (int)header.type)
+        {
+            throw runtime_error("image " + imgFullFilename + " differs in size or type from the first image");
+        }
+
+        uint64_t frameSize = (uint64_t)img.cols * img.rows * img.elemSize();
+        for (int r = 0; r < img.rows; ++r)
+        {
+            out.write((const char *)img.ptr(r), img.cols * img.elemSize());
+        }
+        out.write(padding.data(), header.frameStride - frameSize);
+    }
+
+    if (!out)
+    {
+        throw runtime_error("could not write " + fileName);
+    }
+}
+
+FramePack::FramePack(const string &fileName) : mapping(NULL), mappingSize(0)
+{
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw runtime_error("could not open frame pack " + fileName);
+    }
+
+    struct stat fileStat;
+    bool bValid = fstat(fd, &fileStat) == 0 && (size_t)fileStat.st_size >= sizeof(FramePackHeader) &&
+                  pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) && validHeader(header, fileStat.st_size);
+    if (!bValid)
+    {
+        close(fd);
+        throw runtime_error(fileName + " is not a valid frame pack");
+    }
+
+    mappingSize = fileStat.st_size;
+    void *addr = mmap(NULL, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (addr == MAP_FAILED)
+    {
+        throw runtime_error("could not map frame pack " + fileName);
+    }
+    mapping = (unsigned char *)addr;
+    madvise(mapping, mappingSize, MADV_SEQUENTIAL); // frames are read front to back, let the kernel read ahead
+}
+
+FramePack::~FramePack()
+{
+    munmap(mapping, mappingSize);
+}
+
+cv::Mat FramePack::frame(size_t frameIndex) const
+{
+    if (frameIndex >= size())
+    {
+        throw out_of_range("frame index beyond the end of the frame pack");
+    }
+    unsigned char *data = mapping + header.dataOffset + frameIndex * header.frameStride;
+    return cv::Mat(header.height, header.width, header.type, data);
+}
@@ -0,0 +1,51 @@
+#ifndef framePack_hpp
+#define framePack_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <opencv2/core.hpp>
+
+#include "imageSource.hpp"
+
+
+struct FramePackHeader { // first bytes of a frame pack file, stored in host byte order
+    char magic[8];        // "FRMPACK1"
+    uint32_t width;       // image width in pixels
+    uint32_t height;      // image height in pixels
+    uint32_t type;        // OpenCV type of the images, CV_8UC1 for grayscale
+    uint32_t frameCount;  // no. of frames in the pack
+    uint64_t dataOffset;  // file offset of the first frame
+    uint64_t frameStride; // distance between two frames in bytes, a multiple of the page size
+};
+
+// decode all images of the sequence once and store them uncompressed as a frame pack
+// all images must have the same size, throws runtime_error otherwise or if the sequence is empty
+void writeFramePack(const ImageSequence &sequence, const std::string &fileName, bool bColor);
+
+
+// read-only memory mapping of a frame pack, frames are returned as cv::Mat headers into the mapping
+// several processes reading the same pack share its pages in the page cache
+class FramePack
+{
+public:
+    // throws runtime_error if the file is missing or not a frame pack, or if its header describes frames of an invalid
+    // type or beyond the end of the file
+    explicit FramePack(const std::string &fileName);
+    ~FramePack();
+
+    FramePack(const FramePack &) = delete;
+    FramePack &operator=(const FramePack &) = delete;
+
+    size_t size() const { return header.frameCount; }
+
+    // no pixels are copied or decoded, the returned image is only valid while the pack is open and must not be written to
+    cv::Mat frame(size_t frameIndex) const;
+
+private:
+    FramePackHeader header;
+    unsigned char *mapping;
+    size_t mappingSize;
+};
+
+#endif /* framePack_hpp */
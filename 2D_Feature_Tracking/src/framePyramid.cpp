@@ -0,0 +1,36 @@
+#include "framePyramid.hpp"
+
+using namespace std;
+
+PyramidLayout kltPyramidLayout(int winSize, int maxLevel)
+{
+    PyramidLayout layout = {2.0, maxLevel + 1, winSize};
+    return layout;
+}
+
+cv::Rect roiRegion(cv::Size imgSize, const vector<DetectionRoi> &rois, int margin)
+{
+    cv::Rect image(0, 0, imgSize.width, imgSize.height);
+    if (rois.empty())
+    {
+        return image;
+    }
+
+    cv::Rect region = rois[0].rect;
+    for (const auto &roi : rois)
+    {
+        region = region | roi.rect;
+    }
+    return cv::Rect(region.x - margin, region.y - margin, region.width + 2 * margin, region.height + 2 * margin) & image;
+}
+
+void buildFramePyramid(DataFrame &frame, const cv::Rect &region, const PyramidLayout &layout)
+{
+    frame.pyramidRect = region;
+    frame.pyramid.build(frame.cameraImg(region), layout.scaleFactor, layout.numLevels, layout.border);
+}
+
+bool hasPyramid(const DataFrame &frame, const PyramidLayout &layout)
+{
+    return frame.pyramidRect.area() > 0 && !frame.pyramid.empty() && frame.pyramid.scaleFactor() == layout.scaleFactor;
+}
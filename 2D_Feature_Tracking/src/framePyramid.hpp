@@ -0,0 +1,32 @@
+#ifndef framePyramid_hpp
+#define framePyramid_hpp
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "dataStructures.h"
+#include "imagePyramid.hpp"
+
+
+struct PyramidLayout { // levels of the image pyramid which the stages of a combination share
+    double scaleFactor;
+    int numLevels;       // 0 = the combination needs no pyramid
+    int border;          // pixels around every level which may be read
+};
+
+// levels of cv::ORB::create(), ORB copies the levels it reads into a border of its own
+const PyramidLayout ORB_PYRAMID = {1.2, 8, 0};
+
+// Lucas-Kanade needs octaves and a border of a whole window around every level
+PyramidLayout kltPyramidLayout(int winSize, int maxLevel);
+
+// bounding box of the ROIs enlarged by margin and clipped to the image, the whole image if there are no ROIs
+cv::Rect roiRegion(cv::Size imgSize, const std::vector<DetectionRoi> &rois, int margin);
+
+// pyramid of frame.cameraImg within region, written into the storage of frame.pyramid
+void buildFramePyramid(DataFrame &frame, const cv::Rect &region, const PyramidLayout &layout);
+
+// true if the pyramid of the current image was built with the scale factor of layout
+bool hasPyramid(const DataFrame &frame, const PyramidLayout &layout);
+
+#endif /* framePyramid_hpp */
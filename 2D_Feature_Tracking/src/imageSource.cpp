@@ -0,0 +1,100 @@
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <opencv2/imgcodecs.hpp>
+
+#include "imageSource.hpp"
+#include "metrics.hpp"
+
+using namespace std;
+
+string ImageSequence::fileName(size_t frameIndex) const
+{
+    ostringstream imgNumber;
+    imgNumber << setfill('0') << setw(fillWidth) << startIndex + frameIndex;
+    return basePath + prefix + imgNumber.str() + fileType;
+}
+
+ImageSource::ImageSource(const ImageSequence &sequence, size_t readAhead, size_t numThreads, bool bColor)
+    : sequence(sequence), imreadFlags(bColor ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE),
+      slots(readAhead > 0 ? readAhead : 1), nextToDecode(0), nextToRead(0), bStop(false)
+{
+    // more threads than slots would only wait for a free slot
+    numThreads = max((size_t)1, min(numThreads, slots.size()));
+    for (size_t i = 0; i < numThreads; ++i)
+    {
+        decoders.push_back(thread(&ImageSource::runDecoder, this));
+    }
+}
+
+ImageSource::~ImageSource()
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        bStop = true;
+    }
+    slotFreed.notify_all();
+    for (auto &decoder : decoders)
+    {
+        decoder.join();
+    }
+}
+
+void ImageSource::runDecoder()
+{
+    unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        // a frame may only be claimed once the frame which used its slot before has been read
+        slotFreed.wait(lock, [this] {
+            return bStop || nextToDecode >= sequence.size() || nextToDecode < nextToRead + slots.size();
+        });
+        if (bStop || nextToDecode >= sequence.size())
+        {
+            return;
+        }
+        size_t frameIndex = nextToDecode++;
+        lock.unlock();
+
+        // decoding runs unlocked, so several frames are decoded in parallel
+        double t = (double)cv::getTickCount();
+        cv::Mat img;
+        {
+            ScopedTimer timer("decode");
+            img = cv::imread(sequence.fileName(frameIndex), imreadFlags);
+        }
+        t = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+
+        lock.lock();
+        Slot &slot = slots[frameIndex % slots.size()];
+        slot.img = img;
+        slot.decodeTime = 1000 * t;
+        slot.bReady = true;
+        frameDecoded.notify_all();
+    }
+}
+
+bool ImageSource::read(cv::Mat &img, double &decodeTime)
+{
+    unique_lock<std::mutex> lock(mutex);
+    if (nextToRead >= sequence.size())
+    {
+        return false;
+    }
+
+    Slot &slot = slots[nextToRead % slots.size()];
+    frameDecoded.wait(lock, [&slot] { return slot.bReady; });
+    if (slot.img.empty())
+    {
+        throw runtime_error("could not read image " + sequence.fileName(nextToRead));
+    }
+
+    // hand over the decoded image without copying, the slot gets a fresh buffer from the next imread
+    img = slot.img;
+    slot.img = cv::Mat();
+    decodeTime = slot.decodeTime;
+    slot.bReady = false;
+    nextToRead++;
+    slotFreed.notify_all();
+    return true;
+}
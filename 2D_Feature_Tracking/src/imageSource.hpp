@@ -0,0 +1,61 @@
+#ifndef imageSource_hpp
+#define imageSource_hpp
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/core.hpp>
+
+
+struct ImageSequence { // numbered image files, e.g. <basePath><prefix>0007<fileType>
+    std::string basePath;
+    std::string prefix;
+    std::string fileType;
+    int startIndex = 0; // first file index
+    int endIndex = 0;   // last file index
+    int fillWidth = 4;  // no. of digits which make up the file index
+
+    size_t size() const { return endIndex >= startIndex ? endIndex - startIndex + 1 : 0; }
+    std::string fileName(size_t frameIndex) const; // full path of the frame-th image of the sequence
+};
+
+
+// decodes the images of a sequence ahead of time on a few background threads
+// frames are handed out strictly in sequence order, at most readAhead decoded frames wait in memory
+class ImageSource
+{
+public:
+    ImageSource(const ImageSequence &sequence, size_t readAhead, size_t numThreads, bool bColor);
+    ~ImageSource(); // stops decoding and joins the background threads
+
+    // blocks until the next frame is decoded, returns false after the last frame
+    // decodeTime receives the time the frame spent in imread on its background thread in [ms]
+    // throws runtime_error if the image could not be read
+    bool read(cv::Mat &img, double &decodeTime);
+
+private:
+    struct Slot {
+        cv::Mat img;
+        double decodeTime = 0.0;
+        bool bReady = false;
+    };
+
+    void runDecoder();
+
+    ImageSequence sequence;
+    int imreadFlags;
+
+    std::vector<Slot> slots; // frame i is decoded into slots[i % slots.size()]
+    size_t nextToDecode;     // next frame index claimed by a decoder thread
+    size_t nextToRead;       // next frame index handed out by read()
+    bool bStop;
+
+    std::mutex mutex;
+    std::condition_variable frameDecoded; // a slot became ready
+    std::condition_variable slotFreed;    // read() released a slot
+    std::vector<std::thread> decoders;
+};
+
+#endif /* imageSource_hpp */
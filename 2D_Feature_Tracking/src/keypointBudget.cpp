@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <cmath>
+
+#include "keypointBudget.hpp"
+
+using namespace std;
+
+static const double GAIN = 0.5;      // fraction of the log count error corrected per frame
+static const double MAX_STEP = 0.7;  // the threshold changes by at most about a factor of 2 per frame
+static const double OVERSHOOT = 1.5; // keypoints of a region above OVERSHOOT * its set-point are dropped
+
+ThresholdRange detectorThresholdRange(DetectorKind detectorKind)
+{
+    switch (detectorKind)
+    {
+    case DetectorKind::SHITOMASI:
+        return {0.01, 1e-4, 0.5, false}; // qualityLevel relative to the strongest corner
+    case DetectorKind::HARRIS:
+        return {100, 1, 250, false}; // minResponse on the 0..255 normalized response
+    case DetectorKind::FAST:
+        return {10, 1, 200, true};
+    case DetectorKind::BRISK:
+        return {30, 5, 200, true};
+    case DetectorKind::ORB:
+        return {20, 2, 200, true};
+    case DetectorKind::AKAZE:
+        return {0.001, 1e-5, 0.05, false};
+    case DetectorKind::SIFT:
+        return {0.04, 0.002, 0.3, false};
+    default:
+        return {0, 0, 0, false};
+    }
+}
+
+KeypointBudget::KeypointBudget(DetectorKind detectorKind, RetentionKind retentionKind, int targetKeypoints, double targetTimeMs)
+    : range(detectorThresholdRange(detectorKind)), retentionKind(retentionKind), targetKeypoints(max(targetKeypoints, 1)),
+      targetTimeMs(targetTimeMs), msPerKeypoint(0.0), setPointGauge(NULL), keypointsGauge(NULL)
+{
+    if (Metrics::enabled())
+    {
+        setPointGauge = &Metrics::instance().gauge("keypoint_budget_set_point");
+        keypointsGauge = &Metrics::instance().gauge("keypoint_budget_keypoints");
+    }
+}
+
+double KeypointBudget::quantized(double logThreshold) const
+{
+    // float thresholds move on a ladder of 1/8 octaves, so the registry only ever builds a few dozen detector objects
+    double threshold = range.bInteger ? round(exp(logThreshold)) : exp2(round(8.0 * logThreshold / log(2.0)) / 8.0);
+    return min(max(threshold, range.minValue), range.maxValue);
+}
+
+const vector<DetectionRoi> &KeypointBudget::regions(const vector<DetectionRoi> &rois, cv::Size imgSize)
+{
+    current = rois;
+    if (current.empty())
+    {
+        current.push_back({cv::Rect(0, 0, imgSize.width, imgSize.height), 0, 0.0, retentionKind});
+    }
+    if (logThresholds.size() != current.size())
+    {
+        logThresholds.assign(current.size(), log(range.defaultValue));
+    }
+
+    // the time budget is turned into a keypoint count once the cost of a keypoint has been measured
+    double totalArea = 0.0;
+    for (const auto &region : current)
+    {
+        totalArea += region.rect.area();
+    }
+    double ms;
+    {
+        lock_guard<mutex> lock(costMutex);
+        ms = msPerKeypoint;
+    }
+
+    setPoints.resize(current.size());
+    for (size_t i = 0; i < current.size(); ++i)
+    {
+        if (targetTimeMs > 0.0 && ms > 0.0)
+        {
+            setPoints[i] = max(1, (int)lround(targetTimeMs / ms * current[i].rect.area() / max(totalArea, 1.0)));
+        }
+        else
+        {
+            setPoints[i] = current[i].maxKeypoints > 0 ? current[i].maxKeypoints : targetKeypoints;
+        }
+        current[i].maxKeypoints = (int)ceil(OVERSHOOT * setPoints[i]);
+        current[i].threshold = quantized(logThresholds[i]);
+    }
+    return current;
+}
+
+void KeypointBudget::update(const vector<cv::KeyPoint> &keypoints)
+{
+    for (size_t i = roiSetPointGauges.size(); setPointGauge && i < current.size(); ++i)
+    { // one pair per ROI, so a single controller which misses its set-point stands out
+        roiSetPointGauges.push_back(&Metrics::instance().gauge("keypoint_budget_set_point_roi" + to_string(i)));
+        roiKeypointsGauges.push_back(&Metrics::instance().gauge("keypoint_budget_keypoints_roi" + to_string(i)));
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < current.size(); ++i)
+    {
+        size_t n = count_if(keypoints.begin(), keypoints.end(), [&](const cv::KeyPoint &kpt) { return current[i].rect.contains(kpt.pt); });
+        total += n;
+        if (setPointGauge)
+        {
+            roiSetPointGauges[i]->set(setPoints[i]);
+            roiKeypointsGauges[i]->set(n);
+        }
+
+        // keypoint counts fall roughly with a power of the threshold, so the error is corrected in the log domain
+        double error = log((n + 1.0) / (setPoints[i] + 1.0));
+        double step = min(max(GAIN * error, -MAX_STEP), MAX_STEP);
+        logThresholds[i] = min(max(logThresholds[i] + step, log(range.minValue)), log(range.maxValue));
+    }
+
+    if (setPointGauge)
+    {
+        setPointGauge->set(setPoint());
+        keypointsGauge->set(total);
+    }
+}
+
+void KeypointBudget::recordCost(double ms, size_t numKeypoints)
+{
+    if (numKeypoints == 0)
+    {
+        return;
+    }
+    lock_guard<mutex> lock(costMutex);
+    double sample = ms / numKeypoints;
+    msPerKeypoint = msPerKeypoint > 0.0 ? 0.8 * msPerKeypoint + 0.2 * sample : sample;
+}
+
+int KeypointBudget::setPoint() const
+{
+    int sum = 0;
+    for (int n : setPoints)
+    {
+        sum += n;
+    }
+    return sum;
+}
+
+double KeypointBudget::threshold() const
+{
+    return current.empty() ? range.defaultValue : current[0].threshold;
+}
@@ -0,0 +1,72 @@
+#ifndef keypointBudget_hpp
+#define keypointBudget_hpp
+
+#include <mutex>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "dataStructures.h"
+#include "featureTypes.hpp"
+#include "metrics.hpp"
+
+
+struct ThresholdRange { // detector parameter adjusted by the keypoint budget, larger values always yield fewer keypoints
+    double defaultValue;  // the value the detector is built with otherwise
+    double minValue, maxValue;
+    bool bInteger;        // FAST score thresholds only take integers
+};
+
+// SHITOMASI qualityLevel, HARRIS minResponse, FAST / BRISK / ORB FAST score threshold, AKAZE threshold, SIFT contrastThreshold
+ThresholdRange detectorThresholdRange(DetectorKind detectorKind);
+
+
+// closed-loop control of the detector threshold of every ROI : after each frame the threshold moves by a fraction
+// of the log ratio between the keypoints the ROI yielded and its set-point, so the keypoint count, and the describe
+// and match cost which grows with it, stays near the set-point while the scene changes
+// the set-point is a keypoint count per ROI (the budget of the ROI if it has one), or follows from a time budget for
+// processing a frame divided by the measured cost per keypoint, split over the ROIs by area
+// with metrics enabled, the set-point and the count of the last frame are exported as gauges, summed over the ROIs
+// (keypoint_budget_set_point, keypoint_budget_keypoints) and of every ROI (the same names with the suffix _roi<i>)
+class KeypointBudget
+{
+public:
+    // retentionKind selects the keypoints of the region which covers the whole image when there are no ROIs
+    KeypointBudget(DetectorKind detectorKind, RetentionKind retentionKind, int targetKeypoints, double targetTimeMs = 0.0);
+
+    // rois carrying the thresholds of the next frame, one region covering the whole image if rois is empty
+    // the keypoint limit of every region is a multiple of its set-point, so the detection cuts a sudden burst of texture
+    // with the retention of the region while update still sees the count overshoot
+    const std::vector<DetectionRoi> &regions(const std::vector<DetectionRoi> &rois, cv::Size imgSize);
+
+    // counts the keypoints inside every region and moves the thresholds for the next frame
+    void update(const std::vector<cv::KeyPoint> &keypoints);
+
+    // time of the stages whose cost grows with the keypoints of a frame (describe and match, or KLT tracking)
+    // for numKeypoints keypoints, may be called from another thread
+    void recordCost(double ms, size_t numKeypoints);
+
+    int setPoint() const;     // sum over the regions of the current frame
+    double threshold() const; // threshold of the first region, as handed to the detector
+
+private:
+    double quantized(double logThreshold) const;
+
+    ThresholdRange range;
+    RetentionKind retentionKind;
+    int targetKeypoints;
+    double targetTimeMs;
+
+    std::vector<DetectionRoi> current; // regions of the current frame
+    std::vector<double> logThresholds; // controller state per region, continuous even for integer thresholds
+    std::vector<int> setPoints;
+
+    mutable std::mutex costMutex; // the cost is measured on the match stage thread
+    double msPerKeypoint;         // running average, 0 until the first measurement
+
+    Gauge *setPointGauge;  // NULL without metrics
+    Gauge *keypointsGauge;
+    std::vector<Gauge *> roiSetPointGauges; // of the ROIs seen so far, added by update
+    std::vector<Gauge *> roiKeypointsGauges;
+};
+
+#endif /* keypointBudget_hpp */
@@ -0,0 +1,48 @@
+#include <algorithm>
+
+#include "keypointGrid.hpp"
+
+using namespace std;
+
+KeypointGrid::KeypointGrid(const vector<cv::KeyPoint> &keypoints, float cellSize) : cellSize(cellSize), cols(0), rows(0)
+{
+    if (keypoints.empty())
+    {
+        cellStart.assign(1, 0);
+        return;
+    }
+
+    cv::Point2f maxPt = keypoints[0].pt;
+    origin = keypoints[0].pt;
+    for (const auto &kpt : keypoints)
+    {
+        origin.x = min(origin.x, kpt.pt.x);
+        origin.y = min(origin.y, kpt.pt.y);
+        maxPt.x = max(maxPt.x, kpt.pt.x);
+        maxPt.y = max(maxPt.y, kpt.pt.y);
+    }
+    cols = (int)((maxPt.x - origin.x) / cellSize) + 1;
+    rows = (int)((maxPt.y - origin.y) / cellSize) + 1;
+
+    // counting sort of the keypoints by cell
+    vector<int> cellOf(keypoints.size());
+    cellStart.assign(cols * rows + 1, 0);
+    for (size_t i = 0; i < keypoints.size(); ++i)
+    {
+        int x = (int)((keypoints[i].pt.x - origin.x) / cellSize);
+        int y = (int)((keypoints[i].pt.y - origin.y) / cellSize);
+        cellOf[i] = y * cols + x;
+        cellStart[cellOf[i] + 1]++;
+    }
+    for (size_t c = 1; c < cellStart.size(); ++c)
+    {
+        cellStart[c] += cellStart[c - 1];
+    }
+
+    indices.resize(keypoints.size());
+    vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < keypoints.size(); ++i)
+    {
+        indices[fill[cellOf[i]]++] = i;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef keypointGrid_hpp
+#define keypointGrid_hpp
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <opencv2/core.hpp>
+
+
+// uniform grid over the bounding box of a keypoint list, each cell lists the indices of the keypoints inside it
+// cells are stored back to back (compressed rows), so a radius query touches a few contiguous index ranges
+class KeypointGrid
+{
+public:
+    KeypointGrid(const std::vector<cv::KeyPoint> &keypoints, float cellSize);
+
+    // calls f(index) for every keypoint whose cell overlaps the square of half-width radius around pt,
+    // the caller checks the exact distance if it needs one
+    template <typename F>
+    void forEachNear(const cv::Point2f &pt, float radius, F f) const
+    {
+        int x0 = std::max(0, (int)std::floor((pt.x - radius - origin.x) / cellSize));
+        int y0 = std::max(0, (int)std::floor((pt.y - radius - origin.y) / cellSize));
+        int x1 = std::min(cols - 1, (int)std::floor((pt.x + radius - origin.x) / cellSize));
+        int y1 = std::min(rows - 1, (int)std::floor((pt.y + radius - origin.y) / cellSize));
+        for (int y = y0; y <= y1; ++y)
+        {
+            for (int x = x0; x <= x1; ++x)
+            {
+                int cell = y * cols + x;
+                for (int i = cellStart[cell]; i < cellStart[cell + 1]; ++i)
+                {
+                    f(indices[i]);
+                }
+            }
+        }
+    }
+
+private:
+    cv::Point2f origin; // top-left corner of cell (0,0)
+    float cellSize;
+    int cols, rows;
+    std::vector<int> cellStart; // indices of cell c are indices[cellStart[c]] .. indices[cellStart[c + 1] - 1]
+    std::vector<int> indices;
+};
+
+#endif /* keypointGrid_hpp */
@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "keypointRetention.hpp"
+
+using namespace std;
+
+static const int GRID_KEYPOINTS_PER_CELL = 2; // quota of a cell if every cell of the grid held keypoints
+static const double SSC_TOLERANCE = 0.1;      // square covering stops at a width leaving up to 10 % more, the weakest are cut
+
+struct RetentionScratch { // index lists of the calls on one thread, their capacity survives across frames
+    vector<int> order;     // keypoint indices, grouped by cell or sorted by response
+    vector<int> selected;  // kept indices at the front
+    vector<int> cellOf;
+    vector<int> cellStart; // cell c holds order[cellStart[c]] .. order[cellStart[c + 1] - 1]
+    vector<uchar> covered;
+};
+
+static RetentionScratch &scratch()
+{
+    static thread_local RetentionScratch s;
+    return s;
+}
+
+struct StrongerFirst { // higher response first, equal responses in list order
+    const vector<cv::KeyPoint> &keypoints;
+    bool operator()(int a, int b) const
+    {
+        return keypoints[a].response > keypoints[b].response || (keypoints[a].response == keypoints[b].response && a < b);
+    }
+};
+
+static void keypointBounds(const vector<cv::KeyPoint> &keypoints, cv::Point2f &minPt, cv::Point2f &maxPt)
+{
+    minPt = maxPt = keypoints[0].pt;
+    for (const auto &kpt : keypoints)
+    {
+        minPt.x = min(minPt.x, kpt.pt.x);
+        minPt.y = min(minPt.y, kpt.pt.y);
+        maxPt.x = max(maxPt.x, kpt.pt.x);
+        maxPt.y = max(maxPt.y, kpt.pt.y);
+    }
+}
+
+static int selectBest(const vector<cv::KeyPoint> &keypoints, int maxKeypoints, RetentionScratch &s)
+{
+    s.selected.resize(keypoints.size());
+    iota(s.selected.begin(), s.selected.end(), 0);
+    nth_element(s.selected.begin(), s.selected.begin() + maxKeypoints, s.selected.end(), StrongerFirst{keypoints});
+    return maxKeypoints;
+}
+
+static int selectGrid(const vector<cv::KeyPoint> &keypoints, int maxKeypoints, RetentionScratch &s)
+{
+    const StrongerFirst stronger = {keypoints};
+    const int n = keypoints.size();
+
+    // square cells over the bounding box, as many as the budget fills with GRID_KEYPOINTS_PER_CELL each
+    cv::Point2f minPt, maxPt;
+    keypointBounds(keypoints, minPt, maxPt);
+    float width = maxPt.x - minPt.x + 1.0f, height = maxPt.y - minPt.y + 1.0f;
+    float cellSize = sqrt(width * height / max(1, maxKeypoints / GRID_KEYPOINTS_PER_CELL));
+    int cols = max(1, (int)ceil(width / cellSize)), rows = max(1, (int)ceil(height / cellSize));
+    int numCells = cols * rows;
+    int quota = (maxKeypoints + numCells - 1) / numCells;
+
+    // counting sort of the keypoint indices by cell, cellStart serves as fill cursor and is shifted back afterwards
+    s.cellOf.resize(n);
+    s.cellStart.assign(numCells + 1, 0);
+    for (int i = 0; i < n; ++i)
+    {
+        int x = min(cols - 1, (int)((keypoints[i].pt.x - minPt.x) / cellSize));
+        int y = min(rows - 1, (int)((keypoints[i].pt.y - minPt.y) / cellSize));
+        s.cellOf[i] = y * cols + x;
+        s.cellStart[s.cellOf[i] + 1]++;
+    }
+    partial_sum(s.cellStart.begin(), s.cellStart.end(), s.cellStart.begin());
+    s.order.resize(n);
+    for (int i = 0; i < n; ++i)
+    {
+        s.order[s.cellStart[s.cellOf[i]]++] = i;
+    }
+    copy_backward(s.cellStart.begin(), s.cellStart.end() - 1, s.cellStart.end());
+    s.cellStart[0] = 0;
+
+    // the strongest quota keypoints of every cell to the front of selected, the others to the back
+    s.selected.resize(n);
+    vector<int>::iterator front = s.selected.begin(), back = s.selected.end();
+    for (int c = 0; c < numCells; ++c)
+    {
+        vector<int>::iterator first = s.order.begin() + s.cellStart[c], last = s.order.begin() + s.cellStart[c + 1];
+        vector<int>::iterator mid = last - first > quota ? first + quota : last;
+        nth_element(first, mid, last, stronger);
+        front = copy(first, mid, front);
+        back = copy_backward(mid, last, back);
+    }
+
+    // quota rounds up, and empty cells leave part of the budget to the strongest of the others
+    int winners = front - s.selected.begin();
+    if (winners > maxKeypoints)
+    {
+        nth_element(s.selected.begin(), s.selected.begin() + maxKeypoints, front, stronger);
+    }
+    else
+    {
+        nth_element(front, front + (maxKeypoints - winners), s.selected.end(), stronger);
+    }
+    return maxKeypoints;
+}
+
+// covers the keypoints in order (strongest first) with squares of the given width around each survivor,
+// cells of half the width record what is covered, so a survivor suppresses everything within about width of it
+// stops after limit survivors, which are written to selected if bCollect is set
+static int squareCovering(const vector<cv::KeyPoint> &keypoints, cv::Point2f minPt, cv::Point2f maxPt, int width, int limit,
+                          bool bCollect, RetentionScratch &s)
+{
+    const float cellSize = max(width / 2, 1);
+    const int reach = (int)(width / cellSize);
+    const int cols = (int)((maxPt.x - minPt.x) / cellSize) + 1, rows = (int)((maxPt.y - minPt.y) / cellSize) + 1;
+    s.covered.assign(cols * rows, 0);
+
+    int count = 0;
+    for (size_t i = 0; i < s.order.size() && count < limit; ++i)
+    {
+        const cv::Point2f &pt = keypoints[s.order[i]].pt;
+        int x = (int)((pt.x - minPt.x) / cellSize), y = (int)((pt.y - minPt.y) / cellSize);
+        if (s.covered[y * cols + x])
+        {
+            continue;
+        }
+        if (bCollect)
+        {
+            s.selected[count] = s.order[i];
+        }
+        ++count;
+
+        int x0 = max(0, x - reach), x1 = min(cols - 1, x + reach);
+        for (int yy = max(0, y - reach); yy <= min(rows - 1, y + reach); ++yy)
+        {
+            fill(s.covered.begin() + yy * cols + x0, s.covered.begin() + yy * cols + x1 + 1, 1);
+        }
+    }
+    return count;
+}
+
+static int selectSsc(const vector<cv::KeyPoint> &keypoints, int maxKeypoints, RetentionScratch &s)
+{
+    s.order.resize(keypoints.size());
+    iota(s.order.begin(), s.order.end(), 0);
+    sort(s.order.begin(), s.order.end(), StrongerFirst{keypoints});
+    s.selected.resize(keypoints.size());
+
+    cv::Point2f minPt, maxPt;
+    keypointBounds(keypoints, minPt, maxPt);
+
+    // wider squares leave fewer survivors, so the width is found by binary search; a covering is only counted
+    // as far as needed to tell whether it leaves too many
+    const int maxSurvivors = maxKeypoints + (int)(maxKeypoints * SSC_TOLERANCE);
+    int low = 2, high = 2 * (int)max(maxPt.x - minPt.x, maxPt.y - minPt.y) + 2, chosen = low;
+    while (low <= high)
+    {
+        int mid = low + (high - low) / 2;
+        int count = squareCovering(keypoints, minPt, maxPt, mid, maxSurvivors + 1, false, s);
+        if (count < maxKeypoints)
+        {
+            high = mid - 1;
+        }
+        else
+        {
+            chosen = mid;
+            if (count <= maxSurvivors)
+            {
+                break;
+            }
+            low = mid + 1;
+        }
+    }
+    int count = squareCovering(keypoints, minPt, maxPt, chosen, maxKeypoints, true, s);
+
+    // dense clusters can leave too few even with the narrowest squares, the strongest suppressed ones fill the budget
+    if (count < maxKeypoints)
+    {
+        s.covered.assign(keypoints.size(), 0);
+        for (int i = 0; i < count; ++i)
+        {
+            s.covered[s.selected[i]] = 1;
+        }
+        for (size_t i = 0; i < s.order.size() && count < maxKeypoints; ++i)
+        {
+            if (!s.covered[s.order[i]])
+            {
+                s.selected[count++] = s.order[i];
+            }
+        }
+    }
+    return count;
+}
+
+// keeps keypoints[first[0]], keypoints[first[1]], ... in list order, and their descriptor rows
+// rows are compacted within descriptors, which then views its first count rows, so no matrix is allocated
+static void keepIndices(vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors, vector<int>::iterator first, vector<int>::iterator last)
+{
+    sort(first, last);
+    int count = last - first;
+    bool bDescriptors = !descriptors.empty() && (size_t)descriptors.rows == keypoints.size();
+    for (int i = 0; i < count; ++i)
+    { // first[i] >= i, so no keypoint or row is overwritten before it moved
+        if (first[i] == i)
+        {
+            continue;
+        }
+        keypoints[i] = keypoints[first[i]];
+        if (bDescriptors)
+        {
+            descriptors.row(first[i]).copyTo(descriptors.row(i));
+        }
+    }
+    keypoints.resize(count);
+    if (bDescriptors)
+    {
+        descriptors = descriptors.rowRange(0, count);
+    }
+}
+
+void retainKeypoints(vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors, int maxKeypoints, RetentionKind retentionKind)
+{
+    if (maxKeypoints < 0 || keypoints.size() <= (size_t)maxKeypoints)
+    {
+        return;
+    }
+
+    RetentionScratch &s = scratch();
+    int count = 0;
+    if (maxKeypoints == 0)
+    {
+        s.selected.clear();
+    }
+    else if (retentionKind == RetentionKind::RET_GRID)
+    {
+        count = selectGrid(keypoints, maxKeypoints, s);
+    }
+    else if (retentionKind == RetentionKind::RET_SSC)
+    {
+        count = selectSsc(keypoints, maxKeypoints, s);
+    }
+    else
+    {
+        count = selectBest(keypoints, maxKeypoints, s);
+    }
+    keepIndices(keypoints, descriptors, s.selected.begin(), s.selected.begin() + count);
+}
+
+void retainKeypoints(vector<cv::KeyPoint> &keypoints, int maxKeypoints, RetentionKind retentionKind)
+{
+    cv::Mat noDescriptors;
+    retainKeypoints(keypoints, noDescriptors, maxKeypoints, retentionKind);
+}
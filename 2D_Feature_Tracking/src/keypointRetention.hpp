@@ -0,0 +1,24 @@
+#ifndef keypointRetention_hpp
+#define keypointRetention_hpp
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "featureTypes.hpp"
+
+
+// keeps maxKeypoints of the keypoints in their original order, and their descriptor rows if descriptors holds one row
+// per keypoint (an empty matrix is left as it is); the rows are compacted in place, so matrices which share the data
+// of descriptors see them moved
+// RET_BEST : the strongest ones, by partial selection (nth_element) instead of a full sort
+// RET_GRID : the strongest ones of every cell of a grid over the bounding box of the keypoints, about two per cell,
+//            the quota which empty cells leave is filled with the strongest of the remaining ones
+// RET_SSC  : suppression via square covering (adaptive NMS), the strongest keypoint covers a square around it and
+//            suppresses the weaker ones in it, the square width is searched so that about maxKeypoints survive,
+//            if even the narrowest squares leave fewer, the strongest suppressed ones fill the budget
+// equal responses rank by list position, so keypoints without a response (SHITOMASI, in quality order) keep the first ones
+// the index lists are scratch memory of the calling thread, so no call allocates once the lists have grown
+void retainKeypoints(std::vector<cv::KeyPoint> &keypoints, cv::Mat &descriptors, int maxKeypoints, RetentionKind retentionKind);
+void retainKeypoints(std::vector<cv::KeyPoint> &keypoints, int maxKeypoints, RetentionKind retentionKind);
+
+#endif /* keypointRetention_hpp */
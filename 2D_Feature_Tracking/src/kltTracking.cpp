@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <opencv2/video/tracking.hpp>
+
+#include "kltTracking.hpp"
+#include "keypointGrid.hpp"
+#include "framePyramid.hpp"
+
+using namespace std;
+
+cv::Rect kltRegion(cv::Size imgSize, const vector<DetectionRoi> &rois, int winSize, int maxLevel)
+{
+    // a window on level L covers winSize * 2^L pixels of the image
+    return roiRegion(imgSize, rois, (winSize / 2 + 1) << maxLevel);
+}
+
+void trackKeypointsKlt(const DataFrame &prevFrame, DataFrame &frame, const vector<DetectionRoi> &rois, int winSize, int maxLevel)
+{
+    frame.keypoints.clear();
+    frame.kptMatches.clear();
+    const PyramidLayout layout = kltPyramidLayout(winSize, maxLevel);
+    if (prevFrame.keypoints.empty() || !hasPyramid(prevFrame, layout) || !hasPyramid(frame, layout) ||
+        !(prevFrame.pyramidRect == frame.pyramidRect))
+    { // nothing to track, or the pyramids do not cover the same part of the image
+        return;
+    }
+
+    // the pyramids start at the corner of their region, Lucas-Kanade computes the derivatives of their levels itself
+    const cv::Point2f offset(frame.pyramidRect.x, frame.pyramidRect.y);
+    vector<cv::Point2f> prevPts(prevFrame.keypoints.size()), nextPts;
+    for (size_t i = 0; i < prevPts.size(); ++i)
+    {
+        prevPts[i] = prevFrame.keypoints[i].pt - offset;
+    }
+    vector<uchar> status;
+    vector<float> err;
+    cv::calcOpticalFlowPyrLK(prevFrame.pyramid.views(), frame.pyramid.views(), prevPts, nextPts, status, err, cv::Size(winSize, winSize), maxLevel,
+                             cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 30, 0.01));
+
+    for (size_t i = 0; i < nextPts.size(); ++i)
+    {
+        cv::Point2f pt = nextPts[i] + offset;
+        bool bInside = rois.empty() ? frame.pyramidRect.contains(pt)
+                                    : any_of(rois.begin(), rois.end(), [&pt](const DetectionRoi &roi) { return roi.rect.contains(pt); });
+        if (!status[i] || !bInside)
+        {
+            continue;
+        }
+        cv::KeyPoint kpt = prevFrame.keypoints[i];
+        kpt.pt = pt;
+        frame.kptMatches.push_back(cv::DMatch(i, frame.keypoints.size(), err[i]));
+        frame.keypoints.push_back(kpt);
+    }
+}
+
+void addNewKeypoints(DataFrame &frame, const vector<cv::KeyPoint> &detected, float minDistance)
+{
+    const KeypointGrid grid(frame.keypoints, max(minDistance, 1.0f));
+    const float minDistanceSq = minDistance * minDistance;
+    for (const auto &kpt : detected)
+    {
+        bool bNear = false;
+        grid.forEachNear(kpt.pt, minDistance, [&](int j) {
+            cv::Point2f d = frame.keypoints[j].pt - kpt.pt;
+            bNear = bNear || d.dot(d) < minDistanceSq;
+        });
+        if (!bNear)
+        {
+            frame.keypoints.push_back(kpt);
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef kltTracking_hpp
+#define kltTracking_hpp
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "dataStructures.h"
+
+
+// part of the image which the tracking pyramid covers : the bounding box of the detection ROIs enlarged by
+// the reach of the Lucas-Kanade window on the coarsest level, the whole image if there are no ROIs
+cv::Rect kltRegion(cv::Size imgSize, const std::vector<DetectionRoi> &rois, int winSize, int maxLevel);
+
+// moves the keypoints of prevFrame into frame with pyramidal Lucas-Kanade between the pyramids of both frames
+// (built with kltPyramidLayout over kltRegion),
+// lost tracks and tracks which leave the ROIs are dropped
+// frame.keypoints receives the surviving tracks and frame.kptMatches links them to prevFrame.keypoints as
+// descriptor matching does (queryIdx in prevFrame, trainIdx in frame, distance = tracking error)
+void trackKeypointsKlt(const DataFrame &prevFrame, DataFrame &frame, const std::vector<DetectionRoi> &rois, int winSize, int maxLevel);
+
+// appends the detected keypoints which are at least minDistance away from every keypoint already in the frame
+void addNewKeypoints(DataFrame &frame, const std::vector<cv::KeyPoint> &detected, float minDistance);
+
+#endif /* kltTracking_hpp */
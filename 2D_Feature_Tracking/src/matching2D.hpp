@@ -17,13 +17,78 @@
 #include <opencv2/xfeatures2d/nonfree.hpp>
 
 #include "dataStructures.h"
+#include "featureTypes.hpp"
+#include "threadPool.hpp"
 
 
-void detKeypointsHarris(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool bVis=false);
-void detKeypointsShiTomasi(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool bVis=false);
+// threshold is the detector parameter of detectorThresholdRange (qualityLevel, minResponse, ...), 0 = the detector default
+void detKeypointsHarris(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool bVis=false, double threshold=0.0);
+void detKeypointsShiTomasi(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool bVis=false, double threshold=0.0);
 void detKeypointsModern(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, std::string detectorType, bool bVis=false);
 void descKeypoints(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, cv::Mat &descriptors, std::string descriptorType);
 void matchDescriptors(std::vector<cv::KeyPoint> &kPtsSource, std::vector<cv::KeyPoint> &kPtsRef, cv::Mat &descSource, cv::Mat &descRef,
                       std::vector<cv::DMatch> &matches, std::string descriptorType, std::string matcherType, std::string selectorType);
 
+// typed variants, the string versions above parse their arguments and forward to these
+void detKeypointsModern(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, DetectorKind detectorKind, bool bVis=false, double threshold=0.0);
+void descKeypoints(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, cv::Mat &descriptors, DescriptorKind descriptorKind);
+void matchDescriptors(std::vector<cv::KeyPoint> &kPtsSource, std::vector<cv::KeyPoint> &kPtsRef, cv::Mat &descSource, cv::Mat &descRef,
+                      std::vector<cv::DMatch> &matches, DescriptorDataKind descriptorDataKind, MatcherKind matcherKind, SelectorKind selectorKind);
+
+// radius around the predicted keypoint position searched by guided matching, wider without a motion estimate
+const float GUIDED_SEARCH_RADIUS = 24.0f;
+const float GUIDED_SEARCH_RADIUS_NO_PRIOR = 64.0f;
+
+// match each source keypoint only against reference keypoints within searchRadius of its predicted position
+// prior is the 3x3 homography which maps source to reference positions, an empty prior means no motion
+void matchDescriptorsGuided(std::vector<cv::KeyPoint> &kPtsSource, std::vector<cv::KeyPoint> &kPtsRef, cv::Mat &descSource, cv::Mat &descRef,
+                            std::vector<cv::DMatch> &matches, DescriptorDataKind descriptorDataKind, SelectorKind selectorKind,
+                            const cv::Mat &prior, float searchRadius);
+
+// homography from source to reference positions of the matched keypoints, fitted with RANSAC,
+// a pure translation by the median displacement if there are too few matches, empty if there are none
+cv::Mat estimateMotion(const std::vector<cv::KeyPoint> &kPtsSource, const std::vector<cv::KeyPoint> &kPtsRef,
+                       const std::vector<cv::DMatch> &matches);
+
+// octave of a keypoint as the extractor of descriptorKind reads kpt.octave : SIFT packs the octave into the low byte
+// as a signed char (-1 = the upsampled first octave), ORB stores its pyramid level, the others describe on the image (0)
+int keypointOctave(const cv::KeyPoint &kpt, DescriptorKind descriptorKind);
+
+// margin in pixels around a keypoint which a descriptor reads from the image (including pyramid levels above the keypoint)
+int descriptorPadding(DescriptorKind descriptorKind, float maxKeypointSize, int maxOctave);
+
+// bounding box of all keypoints enlarged by the descriptor padding and clipped to the image, on which the extractor
+// computes the descriptors it computes on the whole image : for SIFT the corner lies on the sample grid of the highest
+// octave, ORB keypoints above the first level (levels resized by 1.2 from the crop) and AKAZE (contrast factor from the
+// histogram of the whole image) get the whole image
+cv::Rect descriptorSupportRect(const std::vector<cv::KeyPoint> &keypoints, cv::Size imgSize, DescriptorKind descriptorKind);
+
+// margin in pixels which a detector needs around a region to find the same keypoints inside it as on the full image
+int detectorRoiBorder(DetectorKind detectorKind);
+
+// run the detector only on the given regions (plus the detector border) and return keypoints in image coordinates
+// every region is searched with its own threshold
+void detKeypointsRoi(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, const std::vector<DetectionRoi> &rois, DetectorKind detectorKind);
+
+// detKeypointsRoi with every region (the whole image if there are none) split into overlapping tiles of the detector
+// border, which are detected in parallel on pool and merged in tile order, see detectTiled
+// SHITOMASI and HARRIS thresholds are relative to the response extremes of each whole region as with detKeypointsRoi,
+// the response of their keypoints is the min. eigenvalue (SHITOMASI) or the response scaled to the region (HARRIS)
+void detKeypointsTiled(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, const std::vector<DetectionRoi> &rois, DetectorKind detectorKind,
+                       ThreadPool *pool);
+
+// detection and description in one detectAndCompute call of the detector object, for isFusedCombination pairs
+// on ROIs, the detector sees each padded region with a mask of the region, so keypoints outside of it are dropped
+// inside the call before any descriptor is computed; the budget of a region drops keypoints with their descriptors
+void detectAndDescribe(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, cv::Mat &descriptors, const std::vector<DetectionRoi> &rois,
+                       DetectorKind detectorKind);
+
+// ORB on the levels of frame.pyramid (built with ORB_PYRAMID) instead of the pyramid which every cv::ORB call builds
+// for itself : a single-level ORB runs on each level with the share of the keypoint budget cv::ORB gives that level
+// detection covers the ROIs (the whole pyramid region if there are none), keypoints are in image coordinates
+void detKeypointsOrbPyramid(std::vector<cv::KeyPoint> &keypoints, const DataFrame &frame, const std::vector<DetectionRoi> &rois);
+// describes every keypoint on the level of its octave, keypoints are reordered by level and those too close
+// to the border of their level are removed, as cv::ORB does
+void descKeypointsOrbPyramid(std::vector<cv::KeyPoint> &keypoints, const DataFrame &frame, cv::Mat &descriptors);
+
 #endif /* matching2D_hpp */
\ No newline at end of file
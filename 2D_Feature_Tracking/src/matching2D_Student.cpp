@@ -1,5 +1,21 @@
 #include <numeric>
+#include <algorithm>
+#include <cfloat>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/core/hal/hal.hpp>
 #include "matching2D.hpp"
+#include "algorithmRegistry.hpp"
+#include "metrics.hpp"
+#include "keypointGrid.hpp"
+#include "nms.hpp"
+#include "harrisEngine.hpp"
+#include "hammingMatcher.hpp"
+#include "l2Matcher.hpp"
+#include "threadPool.hpp"
+#include "frameIndex.hpp"
+#include "framePyramid.hpp"
+#include "keypointRetention.hpp"
+#include "tiledDetection.hpp"
 
 using namespace std;
 
@@ -7,130 +23,307 @@ using namespace std;
 void matchDescriptors(std::vector<cv::KeyPoint> &kPtsSource, std::vector<cv::KeyPoint> &kPtsRef, cv::Mat &descSource, cv::Mat &descRef,
                       std::vector<cv::DMatch> &matches, std::string descriptorType, std::string matcherType, std::string selectorType)
 {
-    // configure matcher
-    bool crossCheck = false;
-    cv::Ptr<cv::DescriptorMatcher> matcher;
+    matchDescriptors(kPtsSource, kPtsRef, descSource, descRef, matches,
+                     parseDescriptorDataKind(descriptorType), parseMatcherKind(matcherType), parseSelectorKind(selectorType));
+}
 
-    if (!matcherType.compare("MAT_BF"))
-    {
-        int normType;
-        if(!descriptorType.compare("DES_BINARY"))
-        {
-            normType=cv::NORM_HAMMING;
-        }
-        else if(!descriptorType.compare("DES_HOG"))
+void matchDescriptors(std::vector<cv::KeyPoint> &kPtsSource, std::vector<cv::KeyPoint> &kPtsRef, cv::Mat &descSource, cv::Mat &descRef,
+                      std::vector<cv::DMatch> &matches, DescriptorDataKind descriptorDataKind, MatcherKind matcherKind, SelectorKind selectorKind)
+{
+    if (descSource.empty() || descRef.empty())
+    { // nothing to match, e.g. no keypoints left in the ROI
+        return;
+    }
+    if (matcherKind == MatcherKind::MAT_GUIDED)
+    { // no motion estimate is passed in here, so every keypoint is searched around its own position
+        matchDescriptorsGuided(kPtsSource, kPtsRef, descSource, descRef, matches, descriptorDataKind, selectorKind,
+                               cv::Mat(), GUIDED_SEARCH_RADIUS_NO_PRIOR);
+        return;
+    }
+
+    ScopedTimer timer("matcher", toString(matcherKind));
+    double minDistanceRatio = 0.8;
+    bool bRatio = usesRatioTest(selectorKind), bMutual = isMutual(selectorKind);
+
+    if (matcherKind == MatcherKind::MAT_BF)
+    { // brute force with ratio test and cross-check fused into the distance loop, same matches as cv::BFMatcher
+        double maxRatio = bRatio ? minDistanceRatio : 0.0;
+        if (descriptorDataKind == DescriptorDataKind::DES_BINARY)
         {
-            normType=cv::NORM_L2;
+            static thread_local HammingMatcher hamming;
+            hamming.match(descSource, descRef, maxRatio, bMutual, matches, &ThreadPool::shared());
         }
         else
         {
-            throw invalid_argument("invalid descriptorType "+descriptorType);
+            static thread_local L2Matcher l2;
+            l2.match(descSource, descRef, maxRatio, bMutual, matches, &ThreadPool::shared());
         }
-        matcher = cv::BFMatcher::create(normType, crossCheck);
+        return;
     }
-    else if (!matcherType.compare("MAT_FLANN"))
+
+    // without frames to attach them to, the indices only live for this call, see FrameIndexMatcher for reusing them
+    DescriptorIndex refIndex, sourceIndex;
+    refIndex.build(descRef, descriptorDataKind);
+    if (bMutual)
     {
-        if(!descriptorType.compare("DES_HOG"))
-        {
-            matcher=cv::FlannBasedMatcher::create();
-        }
-        else if(!descriptorType.compare("DES_BINARY"))
-        {
-            matcher=cv::makePtr<cv::FlannBasedMatcher>(cv::makePtr<cv::flann::LshIndexParams>(12,20,2));
+        sourceIndex.build(descSource, descriptorDataKind);
+    }
+    matchIndexed(descSource, refIndex, descRef, bMutual ? &sourceIndex : NULL, bRatio, matches);
+}
+
+void matchDescriptorsGuided(std::vector<cv::KeyPoint> &kPtsSource, std::vector<cv::KeyPoint> &kPtsRef, cv::Mat &descSource, cv::Mat &descRef,
+                            std::vector<cv::DMatch> &matches, DescriptorDataKind descriptorDataKind, SelectorKind selectorKind,
+                            const cv::Mat &prior, float searchRadius)
+{
+    if (descSource.empty() || descRef.empty())
+    {
+        return;
+    }
+    ScopedTimer timer("matcher", toString(MatcherKind::MAT_GUIDED));
+
+    // predicted position of each source keypoint in the reference frame
+    vector<cv::Point2f> predicted(kPtsSource.size());
+    for (size_t i = 0; i < kPtsSource.size(); ++i)
+    {
+        predicted[i] = kPtsSource[i].pt;
+    }
+    if (!prior.empty())
+    {
+        cv::perspectiveTransform(predicted, predicted, prior);
+    }
+
+    // with cells as large as the search radius, a query visits at most 3x3 cells
+    KeypointGrid grid(kPtsRef, searchRadius);
+    bool bBinary = descriptorDataKind == DescriptorDataKind::DES_BINARY;
+    float radiusSq = searchRadius * searchRadius;
+    double minDistanceRatio = 0.8;
+    bool bRatio = usesRatioTest(selectorKind), bMutual = isMutual(selectorKind);
+
+    // nearest source keypoint of every reference keypoint among the pairs compared below
+    vector<float> colBest(bMutual ? kPtsRef.size() : 0, FLT_MAX);
+    vector<int> colBestIdx(colBest.size(), -1);
+    size_t firstMatch = matches.size();
+
+    for (int i = 0; i < descSource.rows; ++i)
+    {
+        // best and second best candidate, as knnMatch with k=2 would return them
+        float bestDist = FLT_MAX, secondDist = FLT_MAX;
+        int bestIdx = -1;
+        grid.forEachNear(predicted[i], searchRadius, [&](int j) {
+            cv::Point2f d = kPtsRef[j].pt - predicted[i];
+            if (d.dot(d) > radiusSq)
+            {
+                return;
+            }
+            float dist = bBinary ? (float)cv::hal::normHamming(descSource.ptr(i), descRef.ptr(j), descRef.cols)
+                                 : sqrt(cv::hal::normL2Sqr_(descSource.ptr<float>(i), descRef.ptr<float>(j), descRef.cols));
+            if (dist < bestDist)
+            {
+                secondDist = bestDist;
+                bestDist = dist;
+                bestIdx = j;
+            }
+            else if (dist < secondDist)
+            {
+                secondDist = dist;
+            }
+            if (bMutual && dist < colBest[j])
+            {
+                colBest[j] = dist;
+                colBestIdx[j] = i;
+            }
+        });
+
+        if (bestIdx < 0)
+        { // nothing within the search radius
+            continue;
         }
-        else
-        {
-            throw invalid_argument("invalid descriptorType "+descriptorType);
+        if (bRatio && !(secondDist < FLT_MAX && bestDist < minDistanceRatio * secondDist))
+        { // ambiguous, or no second candidate to compare with
+            continue;
         }
+        matches.push_back(cv::DMatch(i, bestIdx, bestDist));
     }
-    else
+
+    if (bMutual)
     {
-        throw invalid_argument("invalid matcherType "+matcherType);
+        auto end = remove_if(matches.begin() + firstMatch, matches.end(), [&](const cv::DMatch &m) { return colBestIdx[m.trainIdx] != m.queryIdx; });
+        matches.erase(end, matches.end());
     }
+}
 
-    // perform matching task
-    if (selectorType.compare("SEL_NN") == 0)
-    { // nearest neighbor (best match)
+cv::Mat estimateMotion(const std::vector<cv::KeyPoint> &kPtsSource, const std::vector<cv::KeyPoint> &kPtsRef,
+                       const std::vector<cv::DMatch> &matches)
+{
+    if (matches.empty())
+    {
+        return cv::Mat();
+    }
 
-        matcher->match(descSource, descRef, matches); // Finds the best match for each descriptor in desc1
+    vector<cv::Point2f> srcPts, refPts;
+    for (const auto &match : matches)
+    {
+        srcPts.push_back(kPtsSource[match.queryIdx].pt);
+        refPts.push_back(kPtsRef[match.trainIdx].pt);
     }
-    else if (selectorType.compare("SEL_KNN") == 0)
-    { // k nearest neighbors (k=2)
-        vector< vector<cv::DMatch> > kmatches;
-        matcher->knnMatch(descSource,descRef,kmatches,2);
 
-        double minDistanceRatio=0.8;
-        for(auto kmatch: kmatches)
+    // a homography needs enough matches for RANSAC to reject the outliers reliably
+    const size_t minHomographyMatches = 12;
+    if (matches.size() >= minHomographyMatches)
+    {
+        cv::Mat homography = cv::findHomography(srcPts, refPts, cv::RANSAC, 3.0);
+        if (!homography.empty())
         {
-            if(kmatch.size()==2 && kmatch[0].distance<minDistanceRatio*kmatch[1].distance)
-            {
-                matches.push_back(kmatch[0]);
-            }
+            return homography;
         }
     }
-    else
+
+    // constant-velocity fallback : median displacement, robust against a few wrong matches
+    vector<float> dx(matches.size()), dy(matches.size());
+    for (size_t i = 0; i < matches.size(); ++i)
     {
-        throw invalid_argument("invalid selectorType "+selectorType);
+        dx[i] = refPts[i].x - srcPts[i].x;
+        dy[i] = refPts[i].y - srcPts[i].y;
     }
+    nth_element(dx.begin(), dx.begin() + dx.size() / 2, dx.end());
+    nth_element(dy.begin(), dy.begin() + dy.size() / 2, dy.end());
+
+    cv::Mat translation = cv::Mat::eye(3, 3, CV_64F);
+    translation.at<double>(0, 2) = dx[dx.size() / 2];
+    translation.at<double>(1, 2) = dy[dy.size() / 2];
+    return translation;
 }
 
 // Use one of several types of state-of-art descriptors to uniquely identify keypoints
 // BRISK, BRIEF, ORB, FREAK, AKAZE, SIFT
 void descKeypoints(vector<cv::KeyPoint> &keypoints, cv::Mat &img, cv::Mat &descriptors, string descriptorType)
 {
-    // select appropriate descriptor
-    cv::Ptr<cv::DescriptorExtractor> extractor;
-    if (!descriptorType.compare("BRISK"))
-    {
+    descKeypoints(keypoints, img, descriptors, parseDescriptorKind(descriptorType));
+}
 
-        int threshold = 30;        // FAST/AGAST detection threshold score.
-        int octaves = 3;           // detection octaves (use 0 to do single scale)
-        float patternScale = 1.0f; // apply this scale to the pattern used for sampling the neighbourhood of a keypoint.
+void descKeypoints(vector<cv::KeyPoint> &keypoints, cv::Mat &img, cv::Mat &descriptors, DescriptorKind descriptorKind)
+{
+    // select appropriate descriptor, built once and reused across frames
+    cv::Ptr<cv::DescriptorExtractor> extractor = AlgorithmRegistry::instance().extractor(descriptorKind);
 
-        extractor = cv::BRISK::create(threshold, octaves, patternScale);
-    }
-    else if(!descriptorType.compare("BRIEF"))
+    // perform feature description on the smallest sub-image which holds the support regions of all keypoints,
+    // so the scale space of SIFT and the integral image of BRISK only cover that area
+    ScopedTimer timer("descriptor", toString(descriptorKind));
+    cv::Rect cropRect = descriptorSupportRect(keypoints, img.size(), descriptorKind);
+    cv::Mat cropImg = img(cropRect); // view into img, no pixels are copied
+
+    cv::Point2f offset(cropRect.x, cropRect.y);
+    for (auto &kpt : keypoints)
     {
-        extractor=cv::xfeatures2d::BriefDescriptorExtractor::create();
+        kpt.pt -= offset;
     }
-    else if(!descriptorType.compare("ORB"))
+    extractor->compute(cropImg, keypoints, descriptors);
+    for (auto &kpt : keypoints)
     {
-        extractor=cv::ORB::create();
+        kpt.pt += offset;
     }
-    else if(!descriptorType.compare("FREAK"))
+}
+
+int keypointOctave(const cv::KeyPoint &kpt, DescriptorKind descriptorKind)
+{
+    switch (descriptorKind)
     {
-        extractor=cv::xfeatures2d::FREAK::create();
+    case DescriptorKind::SIFT:
+    { // as SIFT unpacks it : octave in bits 0-7 (signed), layer in bits 8-15, scale in bits 16-23
+        int octave = kpt.octave & 255;
+        return octave < 128 ? octave : (-128 | octave);
+    }
+    case DescriptorKind::ORB:
+        return kpt.octave;
+    default:
+        return 0;
     }
-    else if(!descriptorType.compare("AKAZE"))
+}
+
+int descriptorPadding(DescriptorKind descriptorKind, float maxKeypointSize, int maxOctave)
+{
+    switch (descriptorKind)
     {
-        extractor=cv::AKAZE::create();
+    case DescriptorKind::BRIEF:
+        return 28; // half of the 48x48 sampling patch + half of the 9x9 smoothing kernel
+    case DescriptorKind::ORB:
+        return (int)ceil(32 * pow(1.2, max(0, maxOctave))); // edgeThreshold 31 on the keypoint's pyramid level
+    case DescriptorKind::FREAK:
+        return 8 + (int)ceil(22.0f * maxKeypointSize / 7.0f); // pattern scale 22 relative to the smallest keypoint size 7
+    case DescriptorKind::BRISK:
+        return 8 + (int)ceil(maxKeypointSize); // outer sampling ring plus its smoothing sigma
+    case DescriptorKind::AKAZE:
+        return 16 + (int)ceil(2.0f * maxKeypointSize); // M-LDB grid plus the reach of nonlinear diffusion
+    case DescriptorKind::SIFT:
+        return 8 + (int)ceil(6.0f * maxKeypointSize); // 4x4 histogram window of 3 sigma per cell, rotated by 45 deg
+    default:
+        return 0;
     }
-    else if(!descriptorType.compare("SIFT"))
+}
+
+cv::Rect descriptorSupportRect(const std::vector<cv::KeyPoint> &keypoints, cv::Size imgSize, DescriptorKind descriptorKind)
+{
+    cv::Rect imgRect(0, 0, imgSize.width, imgSize.height);
+    if (keypoints.empty() || descriptorKind == DescriptorKind::AKAZE)
+    { // a crop would change the AKAZE contrast factor, which comes from the histogram of the whole image
+        return imgRect;
+    }
+
+    float minX = keypoints[0].pt.x, maxX = minX, minY = keypoints[0].pt.y, maxY = minY;
+    float maxSize = 0.0f;
+    int maxOctave = 0;
+    for (const auto &kpt : keypoints)
     {
-        extractor=cv::xfeatures2d::SIFT::create();
+        minX = min(minX, kpt.pt.x);
+        maxX = max(maxX, kpt.pt.x);
+        minY = min(minY, kpt.pt.y);
+        maxY = max(maxY, kpt.pt.y);
+        maxSize = max(maxSize, kpt.size);
+        maxOctave = max(maxOctave, keypointOctave(kpt, descriptorKind));
+    }
+
+    if (descriptorKind == DescriptorKind::ORB && maxOctave > 0)
+    { // the levels above the first are resized from the crop and would sample other pixels than those of the image
+        return imgRect;
     }
 
-    // perform feature description
-    double t = (double)cv::getTickCount();
-    extractor->compute(img, keypoints, descriptors);
-    t = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
-    cout << descriptorType << " descriptor extraction in " << 1000 * t / 1.0 << " ms" << endl;
+    // keypoints closer to the image border than the padding are also that close to the crop border,
+    // so the extractor removes exactly the keypoints it would remove on the full image
+    int pad = descriptorPadding(descriptorKind, maxSize, maxOctave);
+    cv::Rect cropRect = cv::Rect((int)floor(minX) - pad, (int)floor(minY) - pad,
+                                 (int)ceil(maxX) - (int)floor(minX) + 2 * pad + 1, (int)ceil(maxY) - (int)floor(minY) + 2 * pad + 1) & imgRect;
+
+    if (descriptorKind == DescriptorKind::SIFT && maxOctave > 0)
+    { // octave o keeps every 2^o-th pixel of the crop, which are pixels of the full image octave if the corner is a multiple of 2^o
+        int step = 1 << maxOctave;
+        int x = cropRect.x / step * step, y = cropRect.y / step * step;
+        cropRect = cv::Rect(x, y, cropRect.x + cropRect.width - x, cropRect.y + cropRect.height - y);
+    }
+    return cropRect;
 }
 
+// parameters of the traditional detectors, which the tiled detection shares
+static const int SHITOMASI_BLOCK_SIZE = 4;     // derivative covariation block of goodFeaturesToTrack
+static const double SHITOMASI_QUALITY = 0.01;  // default qualityLevel, relative to the strongest corner
+static const int HARRIS_BLOCK_SIZE = 2;
+static const double HARRIS_K = 0.04;
+static const float HARRIS_MIN_RESPONSE = 100;  // default threshold on the 8bit scaled response
+static const float HARRIS_KPT_SIZE = 6;        // 2 * Sobel aperture, keypoint size of the overlap NMS
+
 // Detect keypoints in image using the traditional Shi-Thomasi detector
-void detKeypointsShiTomasi(vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool bVis)
+void detKeypointsShiTomasi(vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool bVis, double threshold)
 {
     // compute detector parameters based on image size
-    int blockSize = 4;       //  size of an average block for computing a derivative covariation matrix over each pixel neighborhood
+    int blockSize = SHITOMASI_BLOCK_SIZE; //  size of an average block for computing a derivative covariation matrix over each pixel neighborhood
     double maxOverlap = 0.0; // max. permissible overlap between two features in %
     double minDistance = (1.0 - maxOverlap) * blockSize;
     int maxCorners = img.rows * img.cols / max(1.0, minDistance); // max. num. of keypoints
 
-    double qualityLevel = 0.01; // minimal accepted quality of image corners
+    double qualityLevel = threshold > 0 ? threshold : SHITOMASI_QUALITY; // minimal accepted quality of image corners
     double k = 0.04;
 
     // Apply corner detection
-    double t = (double)cv::getTickCount();
+    ScopedTimer timer("detector", toString(DetectorKind::SHITOMASI));
     vector<cv::Point2f> corners;
     cv::goodFeaturesToTrack(img, corners, maxCorners, qualityLevel, minDistance, cv::Mat(), blockSize, false, k);
 
@@ -143,8 +336,7 @@ void detKeypointsShiTomasi(vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool b
         newKeyPoint.size = blockSize;
         keypoints.push_back(newKeyPoint);
     }
-    t = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
-    cout << "Shi-Tomasi detection with n=" << keypoints.size() << " keypoints in " << 1000 * t / 1.0 << " ms" << endl;
+    timer.stop();
 
     // visualize results
     if (bVis)
@@ -158,24 +350,25 @@ void detKeypointsShiTomasi(vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool b
     }
 }
 
-void detKeypointsHarris(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool bVis)
+void detKeypointsHarris(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool bVis, double threshold)
 {
     // Detector parameters
-    int blockSize = 2;     // for every pixel, a blockSize × blockSize neighborhood is considered
-    int apertureSize = 3;  // aperture parameter for Sobel operator (must be odd)
-    int minResponse = 100; // minimum value for a corner in the 8bit scaled response matrix
-    double k = 0.04;       // Harris parameter (see equation for details)
-
-    double t=(double)cv::getTickCount();
-    // Detect Harris corners and normalize output
-    cv::Mat dst, dst_norm, dst_norm_scaled;
-    dst = cv::Mat::zeros(img.size(), CV_32FC1);
-    cv::cornerHarris(img, dst, blockSize, apertureSize, k, cv::BORDER_DEFAULT);
-    cv::normalize(dst, dst_norm, 0, 255, cv::NORM_MINMAX, CV_32FC1, cv::Mat());
-    cv::convertScaleAbs(dst_norm, dst_norm_scaled);
+    int blockSize = HARRIS_BLOCK_SIZE; // for every pixel, a blockSize × blockSize neighborhood is considered
+    float minResponse = threshold > 0 ? (float)threshold : HARRIS_MIN_RESPONSE; // minimum value for a corner in the 8bit scaled response matrix
+    double k = HARRIS_K;               // Harris parameter (see equation for details)
+
+    ScopedTimer timer("detector", toString(DetectorKind::HARRIS));
+    // Detect Harris corners in one pass over the image, the engine keeps its buffers across frames
+    static thread_local HarrisEngine harris(blockSize, k);
+    harris.compute(img);
 
+    // the 8-bit scaled response is only needed for visualization
+    cv::Mat dst_norm, dst_norm_scaled;
     if(bVis)
     {
+        harris.normalized(dst_norm);
+        cv::convertScaleAbs(dst_norm, dst_norm_scaled);
+
         // visualize results
         string windowName = "Harris Corner Detector Response Matrix";
         cv::namedWindow(windowName, 4);
@@ -183,96 +376,459 @@ void detKeypointsHarris(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, bool
         cv::waitKey(0);
     }
 
-    if(!keypoints.empty())
+    // non-maximum suppression with the overlap rule, keypoints are looked up in a grid instead of a linear scan
+    // candidates above minResponse on the normalized scale come straight from the engine
+    double maxOverlap=0.0;
+    vector<cv::KeyPoint> candidates;
+    harris.candidates(minResponse, HARRIS_KPT_SIZE, candidates);
+    nmsOverlapGrid(candidates, maxOverlap, keypoints);
+    timer.stop();
+
+    if(bVis)
+    {
+        cv::Mat visImage=dst_norm_scaled.clone();
+        cv::drawKeypoints(dst_norm_scaled,keypoints,visImage,cv::Scalar::all(-1),cv::DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
+        string windowName="Harris corner detection results";
+        cv::namedWindow(windowName,5);
+        cv::imshow(windowName, visImage);
+        cv::waitKey(0);
+    }
+}
+
+//FAST, BRISK, ORB, AKAZE, SIFT
+void detKeypointsModern(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, std::string detectorType, bool bVis)
+{
+    detKeypointsModern(keypoints, img, parseDetectorKind(detectorType), bVis);
+}
+
+void detKeypointsModern(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, DetectorKind detectorKind, bool bVis, double threshold)
+{
+    // the detector is built on first use, so the measured time is the per-frame cost only
+    cv::Ptr<cv::FeatureDetector> detector = AlgorithmRegistry::instance().detector(detectorKind, threshold);
+    ScopedTimer timer("detector", toString(detectorKind));
+    detector->detect(img,keypoints);
+    timer.stop();
+
+    if(bVis)
+    {
+        cv::Mat visImage=img.clone();
+        cv::drawKeypoints(img,keypoints,visImage,cv::Scalar::all(-1),cv::DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
+        string windowName=string(toString(detectorKind))+" keypoint detection results";
+        cv::namedWindow(windowName,6);
+        cv::imshow(windowName,visImage);
+        cv::waitKey(0);
+    }
+}
+
+int detectorRoiBorder(DetectorKind detectorKind)
+{
+    switch (detectorKind)
+    {
+    case DetectorKind::SHITOMASI:
+        return 8; // Sobel aperture + blockSize 4 + min. distance between corners
+    case DetectorKind::HARRIS:
+        return 8; // Sobel aperture + blockSize 2 + keypoint size used for NMS
+    case DetectorKind::FAST:
+        return 4; // Bresenham circle of radius 3 + non-max suppression
+    case DetectorKind::BRISK:
+        return 32; // AGAST radius and 3x3 score refinement on the coarsest of 3 octaves
+    case DetectorKind::ORB:
+        return 112; // edgeThreshold 31 on the coarsest of 8 levels with scale factor 1.2
+    case DetectorKind::AKAZE:
+    case DetectorKind::SIFT:
+        return 64; // Hessian / DoG support on the coarser octaves, finer ones need much less
+    default:
+        return 0;
+    }
+}
+
+void detKeypointsRoi(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, const std::vector<DetectionRoi> &rois, DetectorKind detectorKind)
+{
+    static thread_local vector<cv::KeyPoint> roiKeypoints; // scratch list, keeps its capacity across frames
+
+    cv::Rect imgRect(0, 0, img.cols, img.rows);
+    int border = detectorRoiBorder(detectorKind);
+    keypoints.clear();
+    for (const DetectionRoi &roi : rois)
+    {
+        // the detector sees the region plus its border as a view into img, no pixels are copied
+        cv::Rect paddedRect = cv::Rect(roi.rect.x - border, roi.rect.y - border,
+                                       roi.rect.width + 2 * border, roi.rect.height + 2 * border) & imgRect;
+        if (paddedRect.area() == 0)
+        {
+            continue;
+        }
+        cv::Mat roiImg = img(paddedRect);
+
+        roiKeypoints.clear();
+        if (detectorKind == DetectorKind::SHITOMASI)
+        {
+            detKeypointsShiTomasi(roiKeypoints, roiImg, false, roi.threshold);
+        }
+        else if (detectorKind == DetectorKind::HARRIS)
+        { // note : the response is normalized to the strongest corner within the padded region
+            detKeypointsHarris(roiKeypoints, roiImg, false, roi.threshold);
+        }
+        else
+        {
+            detKeypointsModern(roiKeypoints, roiImg, detectorKind, false, roi.threshold);
+        }
+
+        // map back to image coordinates and drop keypoints which only lie in the border
+        cv::Point2f offset(paddedRect.x, paddedRect.y);
+        auto last = remove_if(roiKeypoints.begin(), roiKeypoints.end(), [&](cv::KeyPoint &kpt) {
+            kpt.pt += offset;
+            return !roi.rect.contains(kpt.pt);
+        });
+        roiKeypoints.erase(last, roiKeypoints.end());
+
+        if (roi.maxKeypoints > 0)
+        { // SHITOMASI corners have no response, but are sorted in descending quality order, so the first ones are kept
+            retainKeypoints(roiKeypoints, roi.maxKeypoints, roi.retention);
+        }
+        keypoints.insert(keypoints.end(), roiKeypoints.begin(), roiKeypoints.end());
+    }
+}
+
+// distance below which keypoints of neighboring tiles are the same or would have suppressed each other on the whole image
+static float detectorMinDistance(DetectorKind detectorKind)
+{
+    switch (detectorKind)
     {
-        keypoints.clear();
+    case DetectorKind::SHITOMASI:
+        return 4.0f; // minDistance between corners
+    case DetectorKind::HARRIS:
+        return 6.0f; // keypoint size of the overlap NMS
+    default:
+        return 1.0f; // the same keypoint, refined to slightly different positions
     }
-    double maxOverlap=0.0; //for non-maximum suppression
-    for(int j=0;j<dst_norm.rows;++j)
+}
+
+// corner selection of cv::goodFeaturesToTrack on a min. eigenvalue image : the 3x3 local maxima above minEigenValue,
+// strongest first, of which every corner closer than minDistance to a stronger one is dropped; the response of a
+// keypoint is its eigenvalue
+static void selectShiTomasiCorners(const cv::Mat &eig, double minEigenValue, double minDistance, float kptSize,
+                                   vector<cv::KeyPoint> &keypoints)
+{
+    static thread_local cv::Mat dilated;
+    static thread_local vector<pair<float, int> > corners; // eigenvalue and raster index
+    cv::dilate(eig, dilated, cv::Mat());
+    corners.clear();
+    for (int y = 1; y < eig.rows - 1; ++y)
     {
-        for(int i=0;i<dst_norm.cols;++i)
+        const float *e = eig.ptr<float>(y), *d = dilated.ptr<float>(y);
+        for (int x = 1; x < eig.cols - 1; ++x)
         {
-            int response=(int)dst_norm.at<float>(j,i);
-            if(response>minResponse)
+            if (e[x] > minEigenValue && e[x] != 0 && e[x] == d[x])
             {
-                cv::KeyPoint newKeyPoint;
-                newKeyPoint.pt=cv::Point2f(i,j);
-                newKeyPoint.size=2*apertureSize;
-                newKeyPoint.response=response;
+                corners.push_back(make_pair(e[x], y * eig.cols + x));
+            }
+        }
+    }
+    // equal eigenvalues in reverse raster order, as goodFeaturesToTrack sorts them by address
+    sort(corners.begin(), corners.end(), [](const pair<float, int> &a, const pair<float, int> &b) {
+        return a.first > b.first || (a.first == b.first && a.second > b.second);
+    });
 
-                bool foundOverlap=false;
-                for(auto it=keypoints.begin();it!=keypoints.end();++it)
+    // cells of minDistance, a stronger corner closer than minDistance lies in one of the 3x3 cells around
+    const int cellSize = max(cvRound(minDistance), 1);
+    const int gridWidth = (eig.cols + cellSize - 1) / cellSize, gridHeight = (eig.rows + cellSize - 1) / cellSize;
+    vector<vector<cv::Point2f> > grid(gridWidth * gridHeight);
+    const float minDistanceSq = (float)(minDistance * minDistance);
+    keypoints.clear();
+    for (const auto &corner : corners)
+    {
+        const int y = corner.second / eig.cols, x = corner.second % eig.cols;
+        const int cx = x / cellSize, cy = y / cellSize;
+        bool bGood = true;
+        for (int gy = max(cy - 1, 0); bGood && gy <= min(cy + 1, gridHeight - 1); ++gy)
+        {
+            for (int gx = max(cx - 1, 0); bGood && gx <= min(cx + 1, gridWidth - 1); ++gx)
+            {
+                for (const cv::Point2f &p : grid[gy * gridWidth + gx])
                 {
-                    double kptOverlap=cv::KeyPoint::overlap(newKeyPoint,*it);
-                    if(kptOverlap>maxOverlap){
-                        foundOverlap=true;
-                        if(newKeyPoint.response>it->response)
-                        {
-                            *it=newKeyPoint;
-                            break;
-                        }
+                    float dx = x - p.x, dy = y - p.y;
+                    if (dx * dx + dy * dy < minDistanceSq)
+                    {
+                        bGood = false;
+                        break;
                     }
                 }
-                if(!foundOverlap)
-                {
-                    keypoints.push_back(newKeyPoint);
-                }
             }
         }
+        if (bGood)
+        {
+            grid[cy * gridWidth + cx].push_back(cv::Point2f(x, y));
+            keypoints.push_back(cv::KeyPoint(cv::Point2f(x, y), kptSize, -1, corner.first));
+        }
     }
-    t=((double)cv::getTickCount()-t)/cv::getTickFrequency();
-    cout << "Harris detection with n=" << keypoints.size() << " keypoints in " << 1000 * t / 1.0 << " ms" << endl;
+}
 
-    if(bVis)
+void detKeypointsTiled(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, const std::vector<DetectionRoi> &rois, DetectorKind detectorKind,
+                       ThreadPool *pool)
+{
+    static thread_local vector<cv::KeyPoint> roiKeypoints; // scratch list, keeps its capacity across frames
+    static thread_local vector<HarrisEngine> harrisBuffers; // response of every tile between the two passes
+    static thread_local vector<cv::Mat> eigenBuffers;       // min. eigenvalues of every tile between the two passes
+
+    const vector<DetectionRoi> whole = {{cv::Rect(0, 0, img.cols, img.rows), 0, 0.0, RetentionKind::RET_BEST}};
+    const vector<DetectionRoi> &regions = rois.empty() ? whole : rois;
+    const int border = detectorRoiBorder(detectorKind);
+    const float minDistance = detectorMinDistance(detectorKind);
+    vector<cv::Ptr<cv::FeatureDetector> > detectors(regions.size());
+    if (detectorKind != DetectorKind::SHITOMASI && detectorKind != DetectorKind::HARRIS)
+    { // the registry objects of features2d are reentrant, all tiles share one
+        for (size_t i = 0; i < regions.size(); ++i)
+        {
+            detectors[i] = AlgorithmRegistry::instance().detector(detectorKind, regions[i].threshold);
+        }
+    }
+    ScopedTimer timer("tiledDetector", toString(detectorKind));
+
+    keypoints.clear();
+    for (size_t i = 0; i < regions.size(); ++i)
     {
-        cv::Mat visImage=dst_norm_scaled.clone();
-        cv::drawKeypoints(dst_norm_scaled,keypoints,visImage,cv::Scalar::all(-1),cv::DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
-        string windowName="Harris corner detection results";
-        cv::namedWindow(windowName,5);
-        cv::imshow(windowName, visImage);
-        cv::waitKey(0);
+        const cv::Rect &region = regions[i].rect;
+        const double threshold = regions[i].threshold;
+        if (detectorKind == DetectorKind::SHITOMASI || detectorKind == DetectorKind::HARRIS)
+        { // the threshold is relative to the extremes of the response on the padded region, as with detKeypointsRoi,
+          // so every tile computes its response first and the extremes of the owned parts are combined in between
+            vector<cv::Rect> cores, tiles;
+            tileRegion(region & cv::Rect(0, 0, img.cols, img.rows), img.size(), border, cores, tiles);
+            vector<float> tileMin(tiles.size()), tileMax(tiles.size());
+            float minValue = 0.0f, maxValue = 0.0f;
+            // the tasks run on the threads of the pool, which must see the buffers of this thread
+            vector<HarrisEngine> &harrisTiles = harrisBuffers;
+            vector<cv::Mat> &eigenTiles = eigenBuffers;
+            TileScan scan;
+            TileDetector detect;
+            if (detectorKind == DetectorKind::SHITOMASI)
+            {
+                eigenTiles.resize(tiles.size());
+                const double qualityLevel = threshold > 0 ? threshold : SHITOMASI_QUALITY;
+                scan = [&](int t, const cv::Mat &tileImg, const cv::Rect &owned) {
+                    cv::cornerMinEigenVal(tileImg, eigenTiles[t], SHITOMASI_BLOCK_SIZE, 3);
+                    double maxEig;
+                    cv::minMaxLoc(eigenTiles[t](owned), nullptr, &maxEig);
+                    tileMax[t] = (float)maxEig;
+                };
+                detect = [&](int t, const cv::Mat &, vector<cv::KeyPoint> &tileKpts) {
+                    selectShiTomasiCorners(eigenTiles[t], qualityLevel * maxValue, minDistance, SHITOMASI_BLOCK_SIZE, tileKpts);
+                };
+            }
+            else
+            {
+                harrisTiles.resize(tiles.size(), HarrisEngine(HARRIS_BLOCK_SIZE, HARRIS_K));
+                const float minResponse = threshold > 0 ? (float)threshold : HARRIS_MIN_RESPONSE;
+                scan = [&](int t, const cv::Mat &tileImg, const cv::Rect &owned) {
+                    harrisTiles[t].compute(tileImg);
+                    double minResp, maxResp;
+                    cv::minMaxLoc(harrisTiles[t].response()(owned), &minResp, &maxResp);
+                    tileMin[t] = (float)minResp;
+                    tileMax[t] = (float)maxResp;
+                };
+                detect = [&](int t, const cv::Mat &, vector<cv::KeyPoint> &tileKpts) {
+                    static thread_local vector<cv::KeyPoint> candidates;
+                    harrisTiles[t].candidates(minResponse, HARRIS_KPT_SIZE, minValue, maxValue, candidates);
+                    nmsOverlapGrid(candidates, 0.0, tileKpts);
+                };
+            }
+            auto reduce = [&]() {
+                minValue = tiles.empty() ? 0.0f : *min_element(tileMin.begin(), tileMin.end());
+                maxValue = tiles.empty() ? 0.0f : *max_element(tileMax.begin(), tileMax.end());
+            };
+            detectTiled(scan, reduce, detect, img, region, border, minDistance, roiKeypoints, pool);
+        }
+        else
+        {
+            detectTiled(detectors[i], img, region, border, minDistance, roiKeypoints, pool);
+        }
+
+        if (regions[i].maxKeypoints > 0)
+        {
+            retainKeypoints(roiKeypoints, regions[i].maxKeypoints, regions[i].retention);
+        }
+        keypoints.insert(keypoints.end(), roiKeypoints.begin(), roiKeypoints.end());
     }
 }
 
-//FAST, BRISK, ORB, AKAZE, SIFT
-void detKeypointsModern(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, std::string detectorType, bool bVis)
+// keypoint budget of a level of cv::ORB::create() : 500 keypoints, the share of a level falls with 1 / scaleFactor
+static int orbLevelBudget(int level)
 {
-	double t=(double)cv::getTickCount();
-    cv::Ptr<cv::FeatureDetector> detector;
-    if(!detectorType.compare("FAST"))
+    const int nfeatures = 500;
+    const double factor = 1.0 / ORB_PYRAMID.scaleFactor;
+    double perLevel = nfeatures * (1.0 - factor) / (1.0 - pow(factor, ORB_PYRAMID.numLevels));
+    int sum = 0, budget = 0;
+    for (int i = 0; i <= level; ++i, perLevel *= factor)
     {
-        detector=cv::FastFeatureDetector::create();
+        budget = i < ORB_PYRAMID.numLevels - 1 ? cvRound(perLevel) : max(nfeatures - sum, 0);
+        sum += budget;
     }
-    else if(!detectorType.compare("BRISK"))
+    return budget;
+}
+
+void detKeypointsOrbPyramid(std::vector<cv::KeyPoint> &keypoints, const DataFrame &frame, const std::vector<DetectionRoi> &rois)
+{
+    static thread_local vector<cv::KeyPoint> roiKeypoints, levelKeypoints; // scratch lists, keep their capacity across frames
+
+    const ImagePyramid &pyramid = frame.pyramid;
+    const vector<DetectionRoi> whole = {{frame.pyramidRect, 0, 0.0, RetentionKind::RET_BEST}};
+    const vector<DetectionRoi> &regions = rois.empty() ? whole : rois;
+    vector<vector<cv::Ptr<cv::Feature2D> > > detectors(regions.size(), vector<cv::Ptr<cv::Feature2D> >(pyramid.levels()));
+    for (size_t i = 0; i < regions.size(); ++i)
     {
-        detector=cv::BRISK::create();
+        int fastThreshold = regions[i].threshold > 0 ? (int)regions[i].threshold : 20;
+        for (int level = 0; level < pyramid.levels(); ++level)
+        {
+            detectors[i][level] = AlgorithmRegistry::instance().orbLevel(orbLevelBudget(level), fastThreshold);
+        }
     }
-    else if(!detectorType.compare("ORB"))
+    ScopedTimer timer("detector", toString(DetectorKind::ORB));
+
+    const int border = 32; // edgeThreshold 31 on every level, no keypoints are found closer to the border
+    const cv::Point2f offset(frame.pyramidRect.x, frame.pyramidRect.y);
+    keypoints.clear();
+    for (size_t i = 0; i < regions.size(); ++i)
     {
-        detector=cv::ORB::create();
+        const DetectionRoi &roi = regions[i];
+        roiKeypoints.clear();
+        for (int level = 0; level < pyramid.levels(); ++level)
+        {
+            // the region on this level plus the border, as a view into the level
+            const cv::Mat &img = pyramid.level(level);
+            const double scale = pyramid.scale(level);
+            int x0 = (int)floor((roi.rect.x - offset.x) / scale), y0 = (int)floor((roi.rect.y - offset.y) / scale);
+            int x1 = (int)ceil((roi.rect.x + roi.rect.width - offset.x) / scale), y1 = (int)ceil((roi.rect.y + roi.rect.height - offset.y) / scale);
+            cv::Rect levelRect = cv::Rect(x0 - border, y0 - border, x1 - x0 + 2 * border, y1 - y0 + 2 * border) & cv::Rect(0, 0, img.cols, img.rows);
+            if (levelRect.area() == 0)
+            {
+                continue;
+            }
+
+            levelKeypoints.clear();
+            detectors[i][level]->detect(img(levelRect), levelKeypoints);
+            for (cv::KeyPoint kpt : levelKeypoints)
+            { // back to image coordinates, with size and octave as cv::ORB sets them
+                kpt.pt = cv::Point2f((kpt.pt.x + levelRect.x) * scale + offset.x, (kpt.pt.y + levelRect.y) * scale + offset.y);
+                if (roi.rect.contains(kpt.pt))
+                {
+                    kpt.size *= scale;
+                    kpt.octave = level;
+                    roiKeypoints.push_back(kpt);
+                }
+            }
+        }
+
+        if (roi.maxKeypoints > 0)
+        {
+            retainKeypoints(roiKeypoints, roi.maxKeypoints, roi.retention);
+        }
+        keypoints.insert(keypoints.end(), roiKeypoints.begin(), roiKeypoints.end());
     }
-    else if(!detectorType.compare("AKAZE"))
+}
+
+void descKeypointsOrbPyramid(std::vector<cv::KeyPoint> &keypoints, const DataFrame &frame, cv::Mat &descriptors)
+{
+    static thread_local vector<cv::KeyPoint> levelKeypoints;
+    static thread_local cv::Mat levelDescriptors;
+
+    cv::Ptr<cv::DescriptorExtractor> extractor = AlgorithmRegistry::instance().orbLevel(orbLevelBudget(0));
+    ScopedTimer timer("descriptor", toString(DescriptorKind::ORB));
+
+    const ImagePyramid &pyramid = frame.pyramid;
+    const cv::Point2f offset(frame.pyramidRect.x, frame.pyramidRect.y);
+    vector<cv::KeyPoint> described;
+    described.reserve(keypoints.size());
+    cv::Mat allDescriptors;
+    for (int level = 0; level < pyramid.levels(); ++level)
     {
-        detector=cv::AKAZE::create();
+        // keypoints of this level in level coordinates, class_id remembers their index
+        const double scale = pyramid.scale(level);
+        levelKeypoints.clear();
+        for (size_t i = 0; i < keypoints.size(); ++i)
+        {
+            if (min(max(keypoints[i].octave, 0), pyramid.levels() - 1) == level)
+            {
+                cv::Point2f pt((keypoints[i].pt.x - offset.x) / scale, (keypoints[i].pt.y - offset.y) / scale);
+                levelKeypoints.push_back(cv::KeyPoint(pt, keypoints[i].size / scale, keypoints[i].angle, keypoints[i].response, 0, (int)i));
+            }
+        }
+        if (levelKeypoints.empty())
+        {
+            continue;
+        }
+
+        // as descKeypoints, the extractor only smooths the part of the level around the keypoints
+        const cv::Mat &img = pyramid.level(level);
+        cv::Rect cropRect = descriptorSupportRect(levelKeypoints, img.size(), DescriptorKind::ORB);
+        cv::Point2f cropOffset(cropRect.x, cropRect.y);
+        for (auto &kpt : levelKeypoints)
+        {
+            kpt.pt -= cropOffset;
+        }
+        extractor->compute(img(cropRect), levelKeypoints, levelDescriptors);
+        for (const auto &kpt : levelKeypoints)
+        {
+            described.push_back(keypoints[kpt.class_id]);
+        }
+        allDescriptors.push_back(levelDescriptors);
     }
-    else if(!detectorType.compare("SIFT"))
+    keypoints.swap(described);
+    descriptors = allDescriptors;
+}
+
+void detectAndDescribe(std::vector<cv::KeyPoint> &keypoints, cv::Mat &img, cv::Mat &descriptors, const std::vector<DetectionRoi> &rois,
+                       DetectorKind detectorKind)
+{
+    static thread_local vector<cv::KeyPoint> roiKeypoints; // scratch list, keeps its capacity across frames
+    static thread_local cv::Mat roiDescriptors, mask;
+
+    // one object serves both phases, the detector and extractor of these pairs have the same parameters
+    vector<cv::Ptr<cv::Feature2D> > features(max<size_t>(rois.size(), 1));
+    for (size_t i = 0; i < features.size(); ++i)
     {
-        detector=cv::xfeatures2d::SIFT::create();
+        features[i] = AlgorithmRegistry::instance().detector(detectorKind, rois.empty() ? 0.0 : rois[i].threshold);
     }
-    else{
-        throw invalid_argument("invalid detectorType "+detectorType);
+    ScopedTimer timer("detectAndCompute", toString(detectorKind));
+    keypoints.clear();
+    if (rois.empty())
+    {
+        features[0]->detectAndCompute(img, cv::noArray(), keypoints, descriptors);
+        return;
     }
-    detector->detect(img,keypoints);
-    t=((double)cv::getTickCount()-t)/cv::getTickFrequency();
-    cout << detectorType<<" detection with n=" << keypoints.size() << " keypoints in " << 1000 * t / 1.0 << " ms" << endl;
 
-    if(bVis)
+    cv::Rect imgRect(0, 0, img.cols, img.rows);
+    int border = detectorRoiBorder(detectorKind);
+    cv::Mat allDescriptors;
+    for (size_t i = 0; i < rois.size(); ++i)
     {
-        cv::Mat visImage=img.clone();
-        cv::drawKeypoints(img,keypoints,visImage,cv::Scalar::all(-1),cv::DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
-        string windowName=detectorType+" keypoint detection results";
-        cv::namedWindow(windowName,6);
-        cv::imshow(windowName,visImage);
-        cv::waitKey(0);
+        const DetectionRoi &roi = rois[i];
+        cv::Rect paddedRect = cv::Rect(roi.rect.x - border, roi.rect.y - border,
+                                       roi.rect.width + 2 * border, roi.rect.height + 2 * border) & imgRect;
+        if (paddedRect.area() == 0)
+        {
+            continue;
+        }
+
+        // the scale space covers the padded region, keypoints are only kept inside the region itself
+        mask.create(paddedRect.height, paddedRect.width, CV_8UC1);
+        mask.setTo(cv::Scalar(0));
+        mask(cv::Rect(roi.rect.x - paddedRect.x, roi.rect.y - paddedRect.y, roi.rect.width, roi.rect.height) &
+             cv::Rect(0, 0, paddedRect.width, paddedRect.height)).setTo(cv::Scalar(255));
+        roiKeypoints.clear();
+        features[i]->detectAndCompute(img(paddedRect), mask, roiKeypoints, roiDescriptors);
+
+        cv::Point2f offset(paddedRect.x, paddedRect.y);
+        for (auto &kpt : roiKeypoints)
+        {
+            kpt.pt += offset;
+        }
+        if (roi.maxKeypoints > 0)
+        {
+            retainKeypoints(roiKeypoints, roiDescriptors, roi.maxKeypoints, roi.retention);
+        }
+        keypoints.insert(keypoints.end(), roiKeypoints.begin(), roiKeypoints.end());
+        allDescriptors.push_back(roiDescriptors);
     }
-}
\ No newline at end of file
+    descriptors = allDescriptors;
+}
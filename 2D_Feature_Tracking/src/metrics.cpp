@@ -0,0 +1,270 @@
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+#include "metrics.hpp"
+
+using namespace std;
+
+/* LATENCY HISTOGRAM */
+
+LatencyHistogram::LatencyHistogram() : totalCount(0), totalSum(0), maxValue(0)
+{
+    for (auto &bucket : buckets)
+    {
+        bucket.store(0, memory_order_relaxed);
+    }
+}
+
+int LatencyHistogram::bucketIndex(uint64_t ns)
+{
+    if (ns < 2 * SUB_BUCKET_COUNT)
+    { // small values are counted exactly
+        return (int)ns;
+    }
+    if (ns >> MAX_VALUE_BITS)
+    {
+        ns = (1ull << MAX_VALUE_BITS) - 1;
+    }
+    int shift = 63 - __builtin_clzll(ns) - SUB_BUCKET_BITS; // the top SUB_BUCKET_BITS + 1 bits select the bucket
+    return shift * SUB_BUCKET_COUNT + (int)(ns >> shift);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < 2 * SUB_BUCKET_COUNT)
+    {
+        return index;
+    }
+    int shift = index / SUB_BUCKET_COUNT - 1;
+    uint64_t subBucket = index % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns)
+{
+    buckets[bucketIndex(ns)].fetch_add(1, memory_order_relaxed);
+    totalCount.fetch_add(1, memory_order_relaxed);
+    totalSum.fetch_add(ns, memory_order_relaxed);
+
+    uint64_t prevMax = maxValue.load(memory_order_relaxed);
+    while (ns > prevMax && !maxValue.compare_exchange_weak(prevMax, ns, memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t LatencyHistogram::percentile(double p) const
+{
+    uint64_t n = count();
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rank = std::max((uint64_t)1, (uint64_t)ceil(p / 100.0 * n));
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += buckets[i].load(memory_order_relaxed);
+        if (seen >= rank)
+        {
+            return std::min(bucketUpperBound(i), max());
+        }
+    }
+    return max();
+}
+
+/* METRICS REGISTRY */
+
+atomic<bool> Metrics::bEnabled(false);
+
+Metrics &Metrics::instance()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+Metrics::~Metrics()
+{
+    try
+    {
+        stopExport();
+    }
+    catch (const runtime_error &re)
+    {
+        cerr << re.what() << endl;
+    }
+}
+
+LatencyHistogram &Metrics::histogram(const string &stage, const string &algorithm)
+{
+    lock_guard<std::mutex> lock(mutex);
+    unique_ptr<LatencyHistogram> &hist = histograms[Key(stage, algorithm)];
+    if (!hist)
+    {
+        hist.reset(new LatencyHistogram());
+    }
+    return *hist;
+}
+
+Gauge &Metrics::gauge(const string &name)
+{
+    lock_guard<std::mutex> lock(mutex);
+    unique_ptr<Gauge> &g = gauges[name];
+    if (!g)
+    {
+        g.reset(new Gauge());
+    }
+    return *g;
+}
+
+static const int HISTOGRAM_CACHE_SIZE = 64; // call sites times algorithms of one thread, about 30 in the tracker
+
+struct HistogramCacheEntry {
+    const char *stage;
+    const char *algorithm;
+    LatencyHistogram *histogram;
+};
+
+LatencyHistogram &Metrics::histogram(const char *stage, const char *algorithm)
+{
+    // open addressing on the label addresses, a full cache falls back to the lookup by name
+    static thread_local HistogramCacheEntry cache[HISTOGRAM_CACHE_SIZE];
+    size_t start = (hash<const void *>()(stage) * 31 + hash<const void *>()(algorithm)) % HISTOGRAM_CACHE_SIZE;
+    for (int i = 0; i < HISTOGRAM_CACHE_SIZE; ++i)
+    {
+        HistogramCacheEntry &entry = cache[(start + i) % HISTOGRAM_CACHE_SIZE];
+        if (entry.stage == stage && entry.algorithm == algorithm)
+        {
+            return *entry.histogram;
+        }
+        if (!entry.stage)
+        {
+            entry.histogram = &histogram(string(stage), string(algorithm));
+            entry.stage = stage;
+            entry.algorithm = algorithm;
+            return *entry.histogram;
+        }
+    }
+    return histogram(string(stage), string(algorithm));
+}
+
+static const double PERCENTILES[] = {50.0, 90.0, 99.0};
+
+void Metrics::writeJson(ostream &os)
+{
+    lock_guard<std::mutex> lock(mutex);
+    os << fixed << setprecision(6) << "[" << endl;
+    size_t i = 0;
+    for (const auto &entry : histograms)
+    {
+        const LatencyHistogram &hist = *entry.second;
+        os << "  {\"stage\": \"" << entry.first.first << "\", \"algorithm\": \"" << entry.first.second
+           << "\", \"count\": " << hist.count() << ", \"mean_ms\": " << (hist.count() ? 1e-6 * hist.sum() / hist.count() : 0.0)
+           << ", \"p50_ms\": " << 1e-6 * hist.percentile(50.0) << ", \"p90_ms\": " << 1e-6 * hist.percentile(90.0)
+           << ", \"p99_ms\": " << 1e-6 * hist.percentile(99.0) << ", \"max_ms\": " << 1e-6 * hist.max() << "}"
+           << (++i < histograms.size() + gauges.size() ? "," : "") << endl;
+    }
+    for (const auto &entry : gauges)
+    {
+        os << "  {\"gauge\": \"" << entry.first << "\", \"value\": " << entry.second->value() << "}"
+           << (++i < histograms.size() + gauges.size() ? "," : "") << endl;
+    }
+    os << "]" << endl;
+}
+
+void Metrics::writePrometheus(ostream &os)
+{
+    lock_guard<std::mutex> lock(mutex);
+    os << setprecision(9);
+    os << "# HELP tracker_stage_latency_seconds latency of a tracker stage or algorithm" << endl
+       << "# TYPE tracker_stage_latency_seconds summary" << endl;
+    for (const auto &entry : histograms)
+    {
+        const LatencyHistogram &hist = *entry.second;
+        string labels = "stage=\"" + entry.first.first + "\",algorithm=\"" + entry.first.second + "\"";
+        for (double p : PERCENTILES)
+        {
+            os << "tracker_stage_latency_seconds{" << labels << ",quantile=\"" << p / 100.0 << "\"} " << 1e-9 * hist.percentile(p) << endl;
+        }
+        os << "tracker_stage_latency_seconds_sum{" << labels << "} " << 1e-9 * hist.sum() << endl
+           << "tracker_stage_latency_seconds_count{" << labels << "} " << hist.count() << endl;
+    }
+    os << "# HELP tracker_stage_latency_max_seconds longest recorded latency of a tracker stage or algorithm" << endl
+       << "# TYPE tracker_stage_latency_max_seconds gauge" << endl;
+    for (const auto &entry : histograms)
+    {
+        os << "tracker_stage_latency_max_seconds{stage=\"" << entry.first.first << "\",algorithm=\"" << entry.first.second << "\"} "
+           << 1e-9 * entry.second->max() << endl;
+    }
+    for (const auto &entry : gauges)
+    {
+        os << "# TYPE tracker_" << entry.first << " gauge" << endl
+           << "tracker_" << entry.first << " " << entry.second->value() << endl;
+    }
+}
+
+// write to a temporary file first, so a scraper never sees a half-written file
+template <typename Writer>
+static void writeFile(const string &fileName, Writer writer)
+{
+    string tmpName = fileName + ".tmp";
+    {
+        ofstream out(tmpName);
+        writer(out);
+        if (!out)
+        {
+            throw runtime_error("could not write metrics file " + tmpName);
+        }
+    }
+    if (rename(tmpName.c_str(), fileName.c_str()) != 0)
+    {
+        throw runtime_error("could not write metrics file " + fileName);
+    }
+}
+
+void Metrics::exportFiles(const string &prefix)
+{
+    writeFile(prefix + ".json", [this](ostream &os) { writeJson(os); });
+    writeFile(prefix + ".prom", [this](ostream &os) { writePrometheus(os); });
+}
+
+void Metrics::startExport(const string &prefix, double intervalSec)
+{
+    stopExport();
+    exportPrefix = prefix;
+    bStopExport = false;
+    exportThread = thread([this, prefix, intervalSec]() {
+        unique_lock<std::mutex> lock(exportMutex);
+        auto interval = chrono::duration<double>(intervalSec);
+        while (!exportWakeup.wait_for(lock, interval, [this] { return bStopExport; }))
+        {
+            try
+            {
+                exportFiles(prefix);
+            }
+            catch (const runtime_error &re)
+            { // keep the tracker running, the next interval may succeed
+                cerr << re.what() << endl;
+            }
+        }
+    });
+}
+
+void Metrics::stopExport()
+{
+    if (!exportThread.joinable())
+    {
+        return;
+    }
+    {
+        lock_guard<std::mutex> lock(exportMutex);
+        bStopExport = true;
+    }
+    exportWakeup.notify_all();
+    exportThread.join();
+    exportFiles(exportPrefix);
+}
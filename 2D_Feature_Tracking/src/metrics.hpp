@@ -0,0 +1,149 @@
+#ifndef metrics_hpp
+#define metrics_hpp
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+
+
+// log-linear latency histogram in the style of HdrHistogram, values are durations in [ns]
+// every power of two is split into 32 linear sub-buckets, so a percentile is accurate to about 3%
+// recording is lock-free and may happen from any thread
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(uint64_t ns);
+
+    uint64_t count() const { return totalCount.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return totalSum.load(std::memory_order_relaxed); }
+    uint64_t max() const { return maxValue.load(std::memory_order_relaxed); }
+    uint64_t percentile(double p) const; // smallest recorded value which at least p percent of all values do not exceed
+
+private:
+    static const int SUB_BUCKET_BITS = 5;
+    static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static const int MAX_VALUE_BITS = 40; // about 18 minutes, longer durations are clamped
+    static const int BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    static int bucketIndex(uint64_t ns);
+    static uint64_t bucketUpperBound(int index);
+
+    std::atomic<uint64_t> buckets[BUCKET_COUNT];
+    std::atomic<uint64_t> totalCount;
+    std::atomic<uint64_t> totalSum;
+    std::atomic<uint64_t> maxValue;
+};
+
+
+// last value of a quantity which is set once per frame, e.g. the set-point of a controller
+// setting is lock-free and may happen from any thread
+class Gauge
+{
+public:
+    Gauge() : current(0.0) {}
+
+    void set(double value) { current.store(value, std::memory_order_relaxed); }
+    double value() const { return current.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> current;
+};
+
+
+// process-wide set of latency histograms, one per stage (load, detect, ...) and algorithm (FAST, BRIEF, ...),
+// and of gauges
+// disabled by default, timers then neither read the clock nor look up a histogram
+class Metrics
+{
+public:
+    static Metrics &instance();
+
+    static bool enabled() { return bEnabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool bOn) { bEnabled.store(bOn, std::memory_order_relaxed); }
+
+    // histogram of the given stage and algorithm, created on first use and valid until the process exits
+    LatencyHistogram &histogram(const std::string &stage, const std::string &algorithm);
+
+    // same for labels in static storage (literals, toString of a kind) : the addresses of the labels identify the
+    // histogram in a cache of the calling thread, so only the first lookup of a call site locks and builds the key
+    LatencyHistogram &histogram(const char *stage, const char *algorithm);
+
+    // gauge of the given name (lower case with underscores), created on first use and valid until the process exits
+    Gauge &gauge(const std::string &name);
+
+    void writeJson(std::ostream &os);
+    void writePrometheus(std::ostream &os);
+
+    // write <prefix>.json and <prefix>.prom, throws runtime_error if a file cannot be written
+    void exportFiles(const std::string &prefix);
+
+    // additionally export every intervalSec seconds on a background thread until stopExport is called
+    void startExport(const std::string &prefix, double intervalSec);
+    void stopExport(); // joins the export thread and writes the final files
+
+private:
+    Metrics() : bStopExport(false) {}
+    ~Metrics();
+
+    typedef std::pair<std::string, std::string> Key; // stage, algorithm
+
+    static std::atomic<bool> bEnabled;
+
+    std::mutex mutex;
+    std::map<Key, std::unique_ptr<LatencyHistogram>> histograms;
+    std::map<std::string, std::unique_ptr<Gauge>> gauges;
+
+    std::string exportPrefix;
+    std::thread exportThread;
+    std::mutex exportMutex;
+    std::condition_variable exportWakeup;
+    bool bStopExport;
+};
+
+
+// measures the lifetime of the timer into the histogram of stage and algorithm, if metrics are enabled
+// the labels must be in static storage, string literals or the names of toString; recording is then lock-free
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(const char *stage, const char *algorithm = "")
+        : histogram(Metrics::enabled() ? &Metrics::instance().histogram(stage, algorithm) : NULL)
+    {
+        if (histogram)
+        {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~ScopedTimer() { stop(); }
+
+    // record now instead of at the end of the scope, e.g. to leave out visualization
+    void stop()
+    {
+        if (histogram)
+        {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+            histogram->record(ns.count());
+            histogram = NULL;
+        }
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+    LatencyHistogram *histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif /* metrics_hpp */
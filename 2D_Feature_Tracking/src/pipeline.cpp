@@ -0,0 +1,271 @@
+#include <iomanip>
+#include <limits>
+#include <thread>
+#include "pipeline.hpp"
+
+using namespace std;
+
+const size_t FramePipeline::END_OF_STREAM = numeric_limits<size_t>::max();
+static const int SPIN_ATTEMPTS = 64; // yields of a stalled stage before it sleeps, covers the short waits between stages
+
+FramePipeline::FramePipeline(size_t historySize, size_t queueCapacity)
+    : historySize(historySize > 0 ? historySize : 1),
+      loaded(queueCapacity), detected(queueCapacity), described(queueCapacity),
+      // enough frames for a full history, full queues between all stages and one frame in flight per stage
+      freeSlots(this->historySize + loaded.capacity() + detected.capacity() + described.capacity() + STAGE_COUNT),
+      stopRequested(false), sleepers(0)
+{
+    slots.resize(freeSlots.capacity());
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+        freeSlots.push(i);
+    }
+}
+
+void FramePipeline::run()
+{
+    thread loadThread(&FramePipeline::runLoad, this);
+    thread detectThread(&FramePipeline::runFrameStage, this, STAGE_DETECT, ref(loaded), ref(detected), cref(detectStage));
+    thread describeThread(&FramePipeline::runFrameStage, this, STAGE_DESCRIBE, ref(detected), ref(described), cref(describeStage));
+
+    runMatch();
+
+    loadThread.join();
+    detectThread.join();
+    describeThread.join();
+
+    if (error)
+    {
+        rethrow_exception(error);
+    }
+}
+
+void FramePipeline::runLoad()
+{
+    for (size_t frameIndex = 0;; ++frameIndex)
+    {
+        size_t slot;
+        if (!popFrame(STAGE_LOAD, freeSlots, slot))
+        {
+            return;
+        }
+
+        DataFrame &frame = slots[slot];
+        frame.reset();
+        bool bMoreFrames;
+        try
+        {
+            bMoreFrames = loadStage(frame, frameIndex);
+        }
+        catch (...)
+        {
+            fail();
+            return;
+        }
+
+        if (!bMoreFrames)
+        { // the unused slot is simply dropped, the pipeline is torn down after this run
+            pushFrame(STAGE_LOAD, loaded, END_OF_STREAM);
+            return;
+        }
+        stageStats[STAGE_LOAD].processed++;
+        if (!pushFrame(STAGE_LOAD, loaded, slot))
+        {
+            return;
+        }
+    }
+}
+
+void FramePipeline::runFrameStage(Stage stage, SpscQueue<size_t> &input, SpscQueue<size_t> &output, const FrameStage &work)
+{
+    size_t slot;
+    while (popFrame(stage, input, slot))
+    {
+        if (slot != END_OF_STREAM)
+        {
+            try
+            {
+                work(slots[slot]);
+            }
+            catch (...)
+            {
+                fail();
+                return;
+            }
+            stageStats[stage].processed++;
+        }
+
+        if (!pushFrame(stage, output, slot) || slot == END_OF_STREAM)
+        {
+            return;
+        }
+    }
+}
+
+void FramePipeline::runMatch()
+{
+    // slots of the most recent frames, oldest first, they are released to the load stage once they drop out
+    vector<size_t> history(historySize);
+    size_t historyNext = 0, historyCount = 0;
+
+    size_t slot;
+    while (popFrame(STAGE_MATCH, described, slot) && slot != END_OF_STREAM)
+    {
+        DataFrame *prevFrame = NULL;
+        if (historyCount > 0)
+        {
+            prevFrame = &slots[history[(historyNext + historySize - 1) % historySize]];
+        }
+
+        try
+        {
+            matchStage(prevFrame, slots[slot]);
+        }
+        catch (...)
+        {
+            fail();
+            return;
+        }
+        stageStats[STAGE_MATCH].processed++;
+
+        if (historyCount == historySize)
+        {
+            pushFrame(STAGE_MATCH, freeSlots, history[historyNext]); // never blocks, the free queue can hold all slots
+        }
+        else
+        {
+            ++historyCount;
+        }
+        history[historyNext] = slot;
+        historyNext = (historyNext + 1) % historySize;
+    }
+}
+
+bool FramePipeline::popFrame(Stage stage, SpscQueue<size_t> &input, size_t &slot)
+{
+    if (!waitUntil([&] { return input.pop(slot); }, stageStats[stage].inputStalls))
+    {
+        return false;
+    }
+    wakeSleepers();
+
+    if (stage != STAGE_LOAD)
+    { // the input of the load stage are free slots, not frames
+        size_t depth = input.size() + 1; // including the frame just taken
+        if (depth > stageStats[stage].maxQueueDepth.load(memory_order_relaxed))
+        {
+            stageStats[stage].maxQueueDepth.store(depth, memory_order_relaxed);
+        }
+    }
+    return true;
+}
+
+bool FramePipeline::pushFrame(Stage stage, SpscQueue<size_t> &output, size_t slot)
+{
+    if (!waitUntil([&] { return output.push(slot); }, stageStats[stage].outputStalls))
+    {
+        return false;
+    }
+    wakeSleepers();
+    return true;
+}
+
+template <typename Attempt>
+bool FramePipeline::waitUntil(Attempt attempt, atomic<uint64_t> &stalls)
+{
+    if (attempt())
+    {
+        return true;
+    }
+    stalls++; // count every wait once, no matter how long it takes
+
+    for (int i = 0; i < SPIN_ATTEMPTS; ++i)
+    {
+        if (stopRequested.load(memory_order_relaxed))
+        {
+            return false;
+        }
+        this_thread::yield();
+        if (attempt())
+        {
+            return true;
+        }
+    }
+
+    // announce the sleeper before the last attempt, wakeSleepers checks for sleepers after its push or pop, so
+    // with the fences on both sides either the attempt sees the change or wakeSleepers sees the sleeper
+    unique_lock<mutex> lock(wakeupMutex);
+    sleepers++;
+    atomic_thread_fence(memory_order_seq_cst);
+    bool bDone = false;
+    wakeup.wait(lock, [&] { return stopRequested.load() || (bDone = attempt()); });
+    sleepers--;
+    return bDone;
+}
+
+void FramePipeline::wakeSleepers()
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (sleepers.load(memory_order_relaxed) > 0)
+    {
+        { // a sleeper holds the mutex from its last attempt until it waits, so the notification cannot fall in between
+            lock_guard<mutex> lock(wakeupMutex);
+        }
+        wakeup.notify_all();
+    }
+}
+
+void FramePipeline::fail()
+{
+    {
+        lock_guard<mutex> lock(errorMutex);
+        if (!error)
+        {
+            error = current_exception();
+        }
+    }
+    stopRequested.store(true);
+    {
+        lock_guard<mutex> lock(wakeupMutex);
+    }
+    wakeup.notify_all();
+}
+
+size_t FramePipeline::queueDepth(Stage stage) const
+{
+    switch (stage)
+    {
+    case STAGE_DETECT:
+        return loaded.size();
+    case STAGE_DESCRIBE:
+        return detected.size();
+    case STAGE_MATCH:
+        return described.size();
+    default:
+        return 0;
+    }
+}
+
+void FramePipeline::printStats(ostream &os) const
+{
+    const char *stageNames[STAGE_COUNT] = {"load", "detect", "describe", "match"};
+
+    os << "stage     frames  in-stalls  out-stalls  queue  max-queue" << endl;
+    for (int i = 0; i < STAGE_COUNT; ++i)
+    {
+        const StageStats &s = stageStats[i];
+        os << left << setw(8) << stageNames[i] << right
+           << setw(8) << s.processed.load()
+           << setw(11) << s.inputStalls.load()
+           << setw(12) << s.outputStalls.load();
+        if (i == STAGE_LOAD)
+        { // the load stage waits for free slots, not for frames
+            os << setw(7) << "-" << setw(11) << "-" << endl;
+        }
+        else
+        {
+            os << setw(7) << queueDepth(static_cast<Stage>(i)) << setw(11) << s.maxQueueDepth.load() << endl;
+        }
+    }
+    os << "free slots " << freeSlotCount() << " of " << slots.size() << endl;
+}
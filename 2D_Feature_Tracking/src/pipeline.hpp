@@ -0,0 +1,93 @@
+#ifndef pipeline_hpp
+#define pipeline_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "dataStructures.h"
+#include "spscQueue.hpp"
+
+
+struct StageStats { // counters of a single pipeline stage, updated by the thread running the stage
+    std::atomic<uint64_t> processed;    // no. of frames which passed the stage
+    std::atomic<uint64_t> inputStalls;  // no. of times the stage had to wait for an input frame
+    std::atomic<uint64_t> outputStalls; // no. of times the stage had to wait for space in its output queue
+    std::atomic<size_t> maxQueueDepth;  // max. no. of frames seen waiting in the input queue, the load stage has none
+
+    StageStats() : processed(0), inputStalls(0), outputStalls(0), maxQueueDepth(0) {}
+};
+
+
+// runs load -> detect -> describe -> match on one thread per stage, connected by bounded SPSC queues
+// frames travel through the stages as indices into a fixed pool of data frames which is recycled through a free queue
+// a stage which finds its input empty or its output full yields for a short while and then sleeps until another
+// stage has pushed or popped a frame
+class FramePipeline
+{
+public:
+    enum Stage { STAGE_LOAD = 0, STAGE_DETECT, STAGE_DESCRIBE, STAGE_MATCH, STAGE_COUNT };
+
+    typedef std::function<bool(DataFrame &frame, size_t frameIndex)> LoadStage; // returns false once there are no more frames
+    typedef std::function<void(DataFrame &frame)> FrameStage;
+    typedef std::function<void(DataFrame *prevFrame, DataFrame &frame)> MatchStage; // prevFrame is null for the first frame
+
+    FramePipeline(size_t historySize, size_t queueCapacity);
+
+    void setLoadStage(const LoadStage &stage) { loadStage = stage; }
+    void setDetectStage(const FrameStage &stage) { detectStage = stage; }
+    void setDescribeStage(const FrameStage &stage) { describeStage = stage; }
+    void setMatchStage(const MatchStage &stage) { matchStage = stage; }
+
+    // blocks until the load stage runs out of frames and all frames have been matched
+    // the match stage runs on the calling thread, so it may safely use highgui
+    // an exception thrown by any stage stops the pipeline and is rethrown here
+    void run();
+
+    const StageStats &stats(Stage stage) const { return stageStats[stage]; }
+    size_t queueDepth(Stage stage) const; // current no. of frames waiting in front of the given stage, 0 for STAGE_LOAD
+    size_t freeSlotCount() const { return freeSlots.size(); } // slots the load stage may currently fill
+    void printStats(std::ostream &os) const;
+
+private:
+    static const size_t END_OF_STREAM;
+
+    void runLoad();
+    void runFrameStage(Stage stage, SpscQueue<size_t> &input, SpscQueue<size_t> &output, const FrameStage &work);
+    void runMatch();
+
+    bool popFrame(Stage stage, SpscQueue<size_t> &input, size_t &slot);
+    bool pushFrame(Stage stage, SpscQueue<size_t> &output, size_t slot);
+    template <typename Attempt>
+    bool waitUntil(Attempt attempt, std::atomic<uint64_t> &stalls); // false if the pipeline stopped first
+    void wakeSleepers(); // after a push or pop, which may end the wait of the stage on the other side
+    void fail();
+
+    size_t historySize;
+    SpscQueue<size_t> loaded;     // load -> detect
+    SpscQueue<size_t> detected;   // detect -> describe
+    SpscQueue<size_t> described;  // describe -> match
+    SpscQueue<size_t> freeSlots;  // match -> load, sized to hold every slot (declared last, depends on the others)
+    std::vector<DataFrame> slots; // frame pool shared by all stages, each slot is owned by one stage at a time
+
+    LoadStage loadStage;
+    FrameStage detectStage;
+    FrameStage describeStage;
+    MatchStage matchStage;
+
+    StageStats stageStats[STAGE_COUNT];
+    std::atomic<bool> stopRequested;
+    std::atomic<int> sleepers; // no. of stages blocked on wakeup
+    std::mutex wakeupMutex;
+    std::condition_variable wakeup;
+    std::exception_ptr error; // first exception thrown by a stage
+    std::mutex errorMutex;
+};
+
+#endif /* pipeline_hpp */
@@ -0,0 +1,126 @@
+// check the KLT levels of ImagePyramid against cv::buildOpticalFlowPyramid, which KLT tracking used before the pyramid
+// was shared with ORB, and compare the Lucas-Kanade tracks of both on the KITTI frames of the tracker
+// the levels must be identical, the tracks may only differ by the derivatives which OpenCV precomputes
+// usage : pyramid_verify [data directory which contains images/, default ../]
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cmath>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/video/tracking.hpp>
+
+#include "matching2D.hpp"
+#include "tracker.hpp"
+#include "kltTracking.hpp"
+#include "framePyramid.hpp"
+#include "imagePyramid.hpp"
+
+using namespace std;
+
+struct TrackComparison {
+    size_t tracks = 0;         // keypoints tracked with both pyramids
+    size_t statusChanges = 0;  // keypoints tracked with only one of them
+    double sumShift = 0.0;     // distance between the two tracked positions
+    double maxShift = 0.0;
+    double sumErrOpenCv = 0.0; // Lucas-Kanade residual with the OpenCV pyramid
+    double sumErrShared = 0.0; // with ImagePyramid
+};
+
+int main(int argc, const char *argv[])
+{
+    TrackerConfig config;
+    if (argc > 1)
+    {
+        config.imgBasePath = string(argv[1]) + "/images/";
+    }
+    const int winSize = config.kltWinSize, maxLevel = config.kltMaxLevel;
+    const PyramidLayout layout = kltPyramidLayout(winSize, maxLevel);
+
+    vector<cv::Mat> frames;
+    ImageSequence sequence = imageSequence(config);
+    for (size_t i = 0; i < sequence.size(); ++i)
+    {
+        cv::Mat img = cv::imread(sequence.fileName(i), cv::IMREAD_GRAYSCALE);
+        if (img.empty())
+        {
+            cerr << "could not read " << sequence.fileName(i) << endl;
+            return 1;
+        }
+        frames.push_back(img);
+    }
+
+    const vector<DetectionRoi> wholeImage;
+    const vector<DetectionRoi> *regions[] = {&wholeImage, &config.rois};
+    size_t differentPixels = 0;
+    for (const vector<DetectionRoi> *rois : regions)
+    {
+        const cv::Rect region = kltRegion(frames[0].size(), *rois, winSize, maxLevel);
+        const cv::Point2f offset(region.x, region.y);
+        vector<cv::Mat> prevOpenCv, openCv;
+        ImagePyramid prevShared, shared;
+        TrackComparison cmp;
+
+        for (size_t f = 0; f < frames.size(); ++f)
+        {
+            // the pyramid of the tracker before and after sharing it, both over the same region
+            cv::buildOpticalFlowPyramid(frames[f](region), openCv, cv::Size(winSize, winSize), maxLevel);
+            shared.build(frames[f](region), layout.scaleFactor, layout.numLevels, layout.border);
+            for (int l = 0; l < shared.levels(); ++l)
+            { // levels and derivatives alternate in the OpenCV pyramid
+                const cv::Mat &level = openCv[2 * l];
+                differentPixels += level.size() == shared.level(l).size() ? cv::countNonZero(level != shared.level(l)) : level.total();
+            }
+
+            if (f > 0)
+            {
+                vector<cv::KeyPoint> keypoints;
+                detKeypointsShiTomasi(keypoints, frames[f - 1]);
+                vector<cv::Point2f> prevPts;
+                for (const auto &kpt : keypoints)
+                {
+                    if (region.contains(kpt.pt))
+                    {
+                        prevPts.push_back(kpt.pt - offset);
+                    }
+                }
+
+                const cv::TermCriteria criteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 30, 0.01);
+                vector<cv::Point2f> ptsOpenCv, ptsShared;
+                vector<uchar> statusOpenCv, statusShared;
+                vector<float> errOpenCv, errShared;
+                cv::calcOpticalFlowPyrLK(prevOpenCv, openCv, prevPts, ptsOpenCv, statusOpenCv, errOpenCv, cv::Size(winSize, winSize),
+                                         maxLevel, criteria);
+                cv::calcOpticalFlowPyrLK(prevShared.views(), shared.views(), prevPts, ptsShared, statusShared, errShared,
+                                         cv::Size(winSize, winSize), maxLevel, criteria);
+                for (size_t i = 0; i < prevPts.size(); ++i)
+                {
+                    if (statusOpenCv[i] != statusShared[i])
+                    {
+                        ++cmp.statusChanges;
+                    }
+                    else if (statusOpenCv[i])
+                    {
+                        double shift = cv::norm(ptsOpenCv[i] - ptsShared[i]);
+                        ++cmp.tracks;
+                        cmp.sumShift += shift;
+                        cmp.maxShift = max(cmp.maxShift, shift);
+                        cmp.sumErrOpenCv += errOpenCv[i];
+                        cmp.sumErrShared += errShared[i];
+                    }
+                }
+            }
+            swap(prevOpenCv, openCv);
+            swap(prevShared, shared);
+        }
+
+        double n = max<size_t>(cmp.tracks, 1);
+        cout << fixed << setprecision(4) << (rois->empty() ? "image" : "ROI") << " : " << cmp.tracks << " tracks, "
+             << cmp.statusChanges << " lost with one pyramid only, shift mean " << cmp.sumShift / n << " max " << cmp.maxShift
+             << " px, mean error " << cmp.sumErrOpenCv / n << " (buildOpticalFlowPyramid) / " << cmp.sumErrShared / n
+             << " (ImagePyramid)" << endl;
+    }
+
+    cout << "level pixels which differ from buildOpticalFlowPyramid : " << differentPixels << endl;
+    return differentPixels == 0 ? 0 : 1;
+}
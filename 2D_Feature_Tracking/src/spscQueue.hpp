@@ -0,0 +1,67 @@
+#ifndef spscQueue_hpp
+#define spscQueue_hpp
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+
+// bounded lock-free queue for exactly one producer thread and one consumer thread
+// head and tail are free-running counters, the slot index is obtained by masking with the power-of-two capacity
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t minCapacity) : head(0), tail(0)
+    {
+        size_t capacity = 1;
+        while (capacity < minCapacity)
+        {
+            capacity <<= 1;
+        }
+        buffer.resize(capacity);
+        mask = capacity - 1;
+    }
+
+    // called by the producer only, returns false if the queue is full
+    bool push(const T &value)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == buffer.size())
+        {
+            return false;
+        }
+        buffer[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // called by the consumer only, returns false if the queue is empty
+    bool pop(T &value)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        value = buffer[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // no. of queued elements, only a snapshot when called while both sides are active
+    size_t size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return buffer.size(); }
+
+private:
+    std::vector<T> buffer;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head; // next element to read, written by the consumer
+    alignas(64) std::atomic<size_t> tail; // next element to write, written by the producer
+};
+
+#endif /* spscQueue_hpp */
@@ -0,0 +1,180 @@
+#include <algorithm>
+
+#include "tiledDetection.hpp"
+#include "keypointGrid.hpp"
+
+using namespace std;
+
+static const int TILE_BORDER_RATIO = 8; // core side in borders, the overlap then adds at most 56 % (1.25^2) to the area
+static const int TILE_MIN_SIZE = 32;    // smaller cores cost more in task overhead than they gain
+static const int TILE_MIN_COUNT = 16;   // tiles which keep 8 threads busy while the sizes of the tasks differ
+
+void tileRegion(const cv::Rect &region, cv::Size imgSize, int border, vector<cv::Rect> &cores, vector<cv::Rect> &tiles)
+{
+    cores.clear();
+    tiles.clear();
+    if (region.area() == 0)
+    {
+        return;
+    }
+
+    // halving the side quadruples the tiles, down to the point where the overlap outgrows the core
+    int side = max(TILE_MIN_SIZE, TILE_BORDER_RATIO * border);
+    int cols = 0, rows = 0;
+    while (true)
+    {
+        cols = max(1, (region.width + side / 2) / side);
+        rows = max(1, (region.height + side / 2) / side);
+        if (cols * rows >= TILE_MIN_COUNT || side / 2 < max(TILE_MIN_SIZE, 2 * border))
+        {
+            break;
+        }
+        side /= 2;
+    }
+
+    const cv::Rect imgRect(0, 0, imgSize.width, imgSize.height);
+    for (int y = 0; y < rows; ++y)
+    {
+        int y0 = region.y + y * region.height / rows, y1 = region.y + (y + 1) * region.height / rows;
+        for (int x = 0; x < cols; ++x)
+        {
+            int x0 = region.x + x * region.width / cols, x1 = region.x + (x + 1) * region.width / cols;
+            cores.push_back(cv::Rect(x0, y0, x1 - x0, y1 - y0));
+            tiles.push_back(cv::Rect(x0 - border, y0 - border, x1 - x0 + 2 * border, y1 - y0 + 2 * border) & imgRect);
+        }
+    }
+}
+
+// drops every keypoint which has a stronger one of another tile closer than minDistance, equal responses keep the
+// keypoint of the earlier tile; only keypoints near a seam between two cores can have such a neighbor
+static void removeSeamDuplicates(vector<cv::KeyPoint> &keypoints, const vector<int> &tileOf, const vector<cv::Rect> &cores,
+                                 const cv::Rect &region, float minDistance)
+{
+    vector<int> nearSeam;
+    vector<cv::KeyPoint> seamKeypoints;
+    for (size_t i = 0; i < keypoints.size(); ++i)
+    {
+        const cv::Rect &core = cores[tileOf[i]];
+        const cv::Point2f &pt = keypoints[i].pt;
+        bool bNear = (core.x > region.x && pt.x - core.x < minDistance) ||
+                     (core.x + core.width < region.x + region.width && core.x + core.width - pt.x < minDistance) ||
+                     (core.y > region.y && pt.y - core.y < minDistance) ||
+                     (core.y + core.height < region.y + region.height && core.y + core.height - pt.y < minDistance);
+        if (bNear)
+        {
+            nearSeam.push_back(i);
+            seamKeypoints.push_back(keypoints[i]);
+        }
+    }
+    if (nearSeam.size() < 2)
+    {
+        return;
+    }
+
+    // the decision of each keypoint only depends on its neighbors, not on the order of the checks
+    const KeypointGrid grid(seamKeypoints, max(minDistance, 1.0f));
+    const float minDistanceSq = minDistance * minDistance;
+    vector<uchar> bDropped(keypoints.size(), 0);
+    for (int a : nearSeam)
+    {
+        grid.forEachNear(keypoints[a].pt, minDistance, [&](int j) {
+            int b = nearSeam[j];
+            cv::Point2f d = keypoints[a].pt - keypoints[b].pt;
+            if (tileOf[a] == tileOf[b] || d.dot(d) >= minDistanceSq)
+            {
+                return;
+            }
+            bool bWeaker = keypoints[a].response < keypoints[b].response ||
+                           (keypoints[a].response == keypoints[b].response && tileOf[a] > tileOf[b]);
+            bDropped[a] = bDropped[a] || bWeaker;
+        });
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < keypoints.size(); ++i)
+    {
+        if (!bDropped[i])
+        {
+            keypoints[kept++] = keypoints[i];
+        }
+    }
+    keypoints.resize(kept);
+}
+
+// the core, extended to the tile on the sides where the core lies on the border of the region
+static cv::Rect ownedPart(const cv::Rect &core, const cv::Rect &tile, const cv::Rect &region)
+{
+    int x0 = core.x == region.x ? tile.x : core.x, y0 = core.y == region.y ? tile.y : core.y;
+    int x1 = core.x + core.width == region.x + region.width ? tile.x + tile.width : core.x + core.width;
+    int y1 = core.y + core.height == region.y + region.height ? tile.y + tile.height : core.y + core.height;
+    return cv::Rect(x0 - tile.x, y0 - tile.y, x1 - x0, y1 - y0);
+}
+
+void detectTiled(const TileScan &scan, const function<void()> &reduce, const TileDetector &detect, const cv::Mat &img,
+                 const cv::Rect &region, int border, float minDistance, vector<cv::KeyPoint> &keypoints, ThreadPool *pool)
+{
+    const cv::Rect clipped = region & cv::Rect(0, 0, img.cols, img.rows);
+    vector<cv::Rect> cores, tiles;
+    tileRegion(clipped, img.size(), border, cores, tiles);
+    auto forEachTile = [&](const function<void(int)> &body) {
+        if (pool)
+        {
+            pool->parallelFor(tiles.size(), body);
+        }
+        else
+        {
+            for (size_t i = 0; i < tiles.size(); ++i)
+            {
+                body(i);
+            }
+        }
+    };
+
+    if (scan)
+    {
+        forEachTile([&](int i) { scan(i, img(tiles[i]), ownedPart(cores[i], tiles[i], clipped)); });
+    }
+    if (reduce)
+    {
+        reduce();
+    }
+
+    // every tile writes its own list, so the merge below sees them in tile order whichever thread ran them
+    vector<vector<cv::KeyPoint> > tileKeypoints(tiles.size());
+    forEachTile([&](int i) {
+        vector<cv::KeyPoint> &tileKpts = tileKeypoints[i];
+        detect(i, img(tiles[i]), tileKpts);
+        const cv::Point2f offset(tiles[i].x, tiles[i].y);
+        const cv::Rect &core = cores[i];
+        auto last = remove_if(tileKpts.begin(), tileKpts.end(), [&](cv::KeyPoint &kpt) {
+            kpt.pt += offset;
+            return !core.contains(kpt.pt);
+        });
+        tileKpts.erase(last, tileKpts.end());
+    });
+
+    keypoints.clear();
+    vector<int> tileOf;
+    for (size_t i = 0; i < tileKeypoints.size(); ++i)
+    {
+        keypoints.insert(keypoints.end(), tileKeypoints[i].begin(), tileKeypoints[i].end());
+        tileOf.resize(keypoints.size(), i);
+    }
+    if (minDistance > 0 && cores.size() > 1)
+    {
+        removeSeamDuplicates(keypoints, tileOf, cores, clipped, minDistance);
+    }
+}
+
+void detectTiled(const TileDetector &detect, const cv::Mat &img, const cv::Rect &region, int border, float minDistance,
+                 vector<cv::KeyPoint> &keypoints, ThreadPool *pool)
+{
+    detectTiled(TileScan(), function<void()>(), detect, img, region, border, minDistance, keypoints, pool);
+}
+
+void detectTiled(const cv::Ptr<cv::FeatureDetector> &detector, const cv::Mat &img, const cv::Rect &region, int border,
+                 float minDistance, vector<cv::KeyPoint> &keypoints, ThreadPool *pool)
+{
+    detectTiled([&detector](int, const cv::Mat &tile, vector<cv::KeyPoint> &tileKpts) { detector->detect(tile, tileKpts); }, img,
+                region, border, minDistance, keypoints, pool);
+}
@@ -0,0 +1,44 @@
+#ifndef tiledDetection_hpp
+#define tiledDetection_hpp
+
+#include <functional>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+
+#include "threadPool.hpp"
+
+
+// detects the keypoints of tile no. tile in tile coordinates, called concurrently for different tiles
+typedef std::function<void(int tile, const cv::Mat &tileImg, std::vector<cv::KeyPoint> &keypoints)> TileDetector;
+
+// first pass of a detector whose threshold is relative to the whole region, called concurrently for different tiles :
+// measures the part owned of the tile (in tile coordinates); the owned parts of all tiles partition the region enlarged
+// by the border, and every owned pixel has the same surroundings within its tile as within the enlarged region
+typedef std::function<void(int tile, const cv::Mat &tileImg, const cv::Rect &owned)> TileScan;
+
+// splits region into a grid of cores of about equal size which partition it, tiles are the cores enlarged by border
+// and clipped to the image; cores are about eight borders (at least 32 pixels) wide, or narrower until there are enough
+// tiles for a pool of eight threads; the layout only depends on region and border, never on the no. of threads
+void tileRegion(const cv::Rect &region, cv::Size imgSize, int border, std::vector<cv::Rect> &cores, std::vector<cv::Rect> &tiles);
+
+// runs detect on every tile of region, in parallel on pool (sequentially without one), and merges the keypoints in
+// image coordinates : a tile keeps the keypoints inside its core, so a keypoint of an overlap is taken from one tile only,
+// and of keypoints from different tiles which are closer than minDistance across a seam (refined positions, or detectors
+// which space their keypoints) only the stronger one is kept
+// the result lists the tiles in row-major order and does not depend on the no. of threads
+// with a border which covers the support of the detector, detectors which decide locally (FAST, or absolute thresholds)
+// find the same keypoints as on the whole region
+void detectTiled(const TileDetector &detect, const cv::Mat &img, const cv::Rect &region, int border, float minDistance,
+                 std::vector<cv::KeyPoint> &keypoints, ThreadPool *pool);
+
+// same in two passes for thresholds relative to the whole region (SHITOMASI, HARRIS) : scan runs on every tile, then
+// reduce once combines what the scans measured into the threshold of the region, then detect runs on every tile
+void detectTiled(const TileScan &scan, const std::function<void()> &reduce, const TileDetector &detect, const cv::Mat &img,
+                 const cv::Rect &region, int border, float minDistance, std::vector<cv::KeyPoint> &keypoints, ThreadPool *pool);
+
+// same with an OpenCV detector, which must allow concurrent detect calls as the detectors of features2d do
+void detectTiled(const cv::Ptr<cv::FeatureDetector> &detector, const cv::Mat &img, const cv::Rect &region, int border,
+                 float minDistance, std::vector<cv::KeyPoint> &keypoints, ThreadPool *pool);
+
+#endif /* tiledDetection_hpp */
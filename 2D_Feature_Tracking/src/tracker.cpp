@@ -0,0 +1,352 @@
+#include <iostream>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+
+#include "tracker.hpp"
+#include "matching2D.hpp"
+#include "pipeline.hpp"
+#include "imageSource.hpp"
+#include "framePack.hpp"
+#include "algorithmRegistry.hpp"
+#include "trackingStages.hpp"
+#include "frameIndex.hpp"
+#include "kltTracking.hpp"
+#include "framePyramid.hpp"
+#include "keypointBudget.hpp"
+#include "threadPool.hpp"
+#include "metrics.hpp"
+
+using namespace std;
+
+// time elapsed since t0 in [ms]
+static double elapsedMs(double t0)
+{
+    return 1000.0 * ((double)cv::getTickCount() - t0) / cv::getTickFrequency();
+}
+
+ImageSequence imageSequence(const TrackerConfig &config)
+{
+    ImageSequence sequence;
+    sequence.basePath = config.imgBasePath;
+    sequence.prefix = config.imgPrefix;
+    sequence.fileType = config.imgFileType;
+    sequence.startIndex = config.imgStartIndex;
+    sequence.endIndex = config.imgEndIndex;
+    sequence.fillWidth = config.imgFillWidth;
+    return sequence;
+}
+
+void runTracker(const TrackerConfig &config, const FrameCallback &onFrame)
+{
+    const TrackerConfig &c = config;
+
+    // prebuilt stage functions of the configured combination, no string dispatch inside the frame loop
+    StageTable stages = selectStages(c.detectorKind, c.descriptorKind, c.matcherKind, c.selectorKind);
+
+    // detector and descriptor of the same algorithm share one scale space, descriptors are then computed in the detect stage
+    const bool bFused = c.bFuseDetectDescribe && !c.bKlt && stages.detectAndDescribe != NULL;
+
+    // search indices of the frames in the ring buffer, only used by MAT_FLANN, saved per detector and descriptor
+    FrameIndexMatcher frameIndices(c.indexDir, string(toString(c.detectorKind)) + "_" + toString(c.descriptorKind));
+
+    // only detect keypoints on the preceding vehicle, the detector runs on the ROIs instead of the whole image
+    // and every ROI keeps its budget with the configured retention
+    vector<DetectionRoi> rois = c.bFocusOnVehicle ? c.rois : vector<DetectionRoi>();
+    for (auto &roi : rois)
+    {
+        roi.retention = c.retentionKind;
+    }
+
+    // OpenCV detectors and extractors cannot be handed a pyramid, so only the stages which read frame.pyramid share one :
+    // KLT tracking, and ORB detection and description
+    PyramidLayout pyramidLayout = {2.0, 0, 0};
+    if (c.bKlt)
+    {
+        pyramidLayout = kltPyramidLayout(c.kltWinSize, c.kltMaxLevel);
+    }
+    else if (c.detectorKind == DetectorKind::ORB || c.descriptorKind == DescriptorKind::ORB)
+    {
+        pyramidLayout = ORB_PYRAMID;
+    }
+
+    // tiled detection runs on the shared pool, except where ORB detects on the levels of the frame pyramid
+    const bool bTiled = c.bTiledDetection && !bFused && (c.bKlt || c.detectorKind != DetectorKind::ORB);
+
+    // detector thresholds under closed-loop control, moved by the detect stage and fed with the cost of the match stage
+    // (describe and match, or KLT tracking)
+    unique_ptr<KeypointBudget> budget;
+    if (c.bKeypointBudget)
+    {
+        budget.reset(new KeypointBudget(c.detectorKind, c.retentionKind, c.budgetKeypoints, c.budgetTimeMs));
+    }
+
+    /* PROCESSING STAGES */
+
+    // images either come from a memory-mapped frame pack or are decoded ahead on background threads,
+    // directly to grayscale as no stage needs color
+    unique_ptr<FramePack> framePack;
+    unique_ptr<ImageSource> imageSource;
+    if (!c.framePackFile.empty())
+    {
+        framePack.reset(new FramePack(c.framePackFile));
+    }
+    else
+    {
+        imageSource.reset(new ImageSource(imageSequence(c), c.readAheadFrames, c.decodeThreads, false));
+    }
+
+    auto loadImage = [&](DataFrame &frame, size_t imgIndex) -> bool {
+        ScopedTimer timer("load");
+        double t = (double)cv::getTickCount();
+
+        /* LOAD IMAGE INTO BUFFER */
+
+        //// STUDENT ASSIGNMENT
+        //// TASK MP.1 -> replace the following code with ring buffer of size dataBufferSize
+
+        if (framePack)
+        { // the frame is a view into the mapped pack, nothing is copied or decoded
+            if (imgIndex >= framePack->size())
+            {
+                return false;
+            }
+            frame.cameraImg = framePack->frame(imgIndex);
+        }
+        else if (!imageSource->read(frame.cameraImg, frame.stats.decodeTime))
+        { // take over the next decoded grayscale image, only blocks if decoding has fallen behind
+            return false;
+        }
+
+        //// EOF STUDENT ASSIGNMENT
+        frame.stats.frameIndex = imgIndex;
+        frame.stats.loadTime = elapsedMs(t);
+        if (c.bVerbose)
+        {
+            cout << "#1 : LOAD IMAGE INTO BUFFER done in " << frame.stats.loadTime << " ms" << endl;
+        }
+        return true;
+    };
+
+    // the pyramid is built once per frame, before detection, and read by all later stages of the frame
+    auto buildPyramid = [&](DataFrame &frame) {
+        ScopedTimer timer("pyramid");
+        double t = (double)cv::getTickCount();
+        cv::Size imgSize = frame.cameraImg.size();
+        // ORB levels are resized from the whole image as cv::ORB resizes them, levels of a crop would sample other pixels
+        cv::Rect region = c.bKlt ? kltRegion(imgSize, rois, c.kltWinSize, c.kltMaxLevel) : cv::Rect(0, 0, imgSize.width, imgSize.height);
+        buildFramePyramid(frame, region, pyramidLayout);
+        frame.stats.pyramidTime = elapsedMs(t);
+    };
+
+    auto detectKeypoints = [&](DataFrame &frame) {
+        ScopedTimer timer("detect", toString(c.detectorKind));
+        double t = (double)cv::getTickCount();
+        if (!c.bKlt && pyramidLayout.numLevels > 0)
+        { // in KLT mode, the detect stage already built the pyramid
+            buildPyramid(frame);
+        }
+
+        /* DETECT IMAGE KEYPOINTS */
+
+        // extract 2D keypoints from current image into the keypoint list of the current frame
+        vector<cv::KeyPoint> &keypoints = frame.keypoints;
+
+        //// STUDENT ASSIGNMENT
+        //// TASK MP.2 -> add the following keypoint detectors in file matching2D.cpp and enable string-based selection based on detectorType
+        //// -> HARRIS, FAST, BRISK, ORB, AKAZE, SIFT
+        //// TASK MP.3 -> only keep keypoints on the preceding vehicle
+
+        const vector<DetectionRoi> &detectionRois = budget ? budget->regions(rois, frame.cameraImg.size()) : rois;
+        if (bFused)
+        {
+            stages.detectAndDescribe(frame, detectionRois);
+        }
+        else if (bTiled)
+        {
+            detKeypointsTiled(keypoints, frame.cameraImg, detectionRois, c.detectorKind, &ThreadPool::shared());
+        }
+        else
+        {
+            stages.detect(frame, detectionRois);
+        }
+        frame.stats.numDetectedKpts = keypoints.size();
+
+        if (c.bVerbose)
+        {
+            cout<<"---> keypoints on preceding vehicle = "<<keypoints.size()<<endl;
+        }
+
+        //// EOF STUDENT ASSIGNMENT
+
+        // keypoint budget : the count of this frame moves the thresholds of the next one, the detection already cut
+        // every region far above its set-point so a sudden burst of texture does not stall the later stages
+        if (budget)
+        {
+            budget->update(keypoints);
+            frame.stats.keypointSetPoint = budget->setPoint();
+            frame.stats.detectorThreshold = budget->threshold();
+            if (c.bVerbose)
+            {
+                cout << " keypoint budget : set-point " << frame.stats.keypointSetPoint << ", threshold " << frame.stats.detectorThreshold
+                     << endl;
+            }
+        }
+
+        frame.stats.numKeypoints = keypoints.size();
+        frame.stats.detectTime = elapsedMs(t);
+        if (c.bVerbose)
+        {
+            cout << (bFused ? "#2 : DETECT AND DESCRIBE KEYPOINTS done in " : "#2 : DETECT KEYPOINTS done in ") << frame.stats.detectTime << " ms" << endl;
+        }
+    };
+
+    auto describeKeypoints = [&](DataFrame &frame) {
+        ScopedTimer timer("describe", toString(c.descriptorKind));
+        double t = (double)cv::getTickCount();
+
+        /* EXTRACT KEYPOINT DESCRIPTORS */
+
+        //// STUDENT ASSIGNMENT
+        //// TASK MP.4 -> add the following descriptors in file matching2D.cpp and enable string-based selection based on descriptorType
+        //// -> BRIEF, ORB, FREAK, AKAZE, SIFT
+
+        // descriptors are written into the descriptor matrix of the current frame
+        stages.describe(frame);
+        //// EOF STUDENT ASSIGNMENT
+
+        frame.stats.describeTime = elapsedMs(t);
+        if (c.bVerbose)
+        {
+            cout << "#3 : EXTRACT DESCRIPTORS done in " << frame.stats.describeTime << " ms" << endl;
+        }
+    };
+
+    auto matchKeypoints = [&](DataFrame *prevFrame, DataFrame &frame) {
+        if (prevFrame != NULL) // wait until at least two images have been processed
+        {
+            ScopedTimer timer("match", toString(c.matcherKind));
+            double t = (double)cv::getTickCount();
+
+            /* MATCH KEYPOINT DESCRIPTORS */
+
+            vector<cv::DMatch> &matches = frame.kptMatches; // matches are stored in current data frame
+
+            //// STUDENT ASSIGNMENT
+            //// TASK MP.5 -> add FLANN matching in file matching2D.cpp
+            //// TASK MP.6 -> add KNN match selection and perform descriptor distance ratio filtering with t=0.8 in file matching2D.cpp
+
+            stages.match(*prevFrame, frame, frameIndices);
+
+            //// EOF STUDENT ASSIGNMENT
+
+            frame.stats.numMatches = matches.size();
+            frame.stats.matchTime = elapsedMs(t);
+            if (budget)
+            { // the part of the frame latency which grows with the no. of keypoints
+                budget->recordCost(frame.stats.describeTime + frame.stats.matchTime, frame.stats.numKeypoints);
+            }
+            if (c.bVerbose)
+            {
+                cout << "# matches: " << matches.size() << endl;
+                cout << "#4 : MATCH KEYPOINT DESCRIPTORS done in " << frame.stats.matchTime << " ms" << endl;
+            }
+        }
+
+        if (onFrame)
+        {
+            onFrame(prevFrame, frame);
+        }
+    };
+
+    /* KLT TRACKING */
+
+    // the detect stage only builds the pyramid of the frame, which the next frame tracks from
+    auto trackingPyramid = [&](DataFrame &frame) {
+        buildPyramid(frame);
+        frame.stats.detectTime = frame.stats.pyramidTime;
+    };
+
+    // tracks replace descriptor matching, the detector only runs once too few tracks survive
+    auto trackKeypoints = [&](DataFrame *prevFrame, DataFrame &frame) {
+        if (prevFrame != NULL)
+        {
+            ScopedTimer timer("match", "KLT");
+            double t = (double)cv::getTickCount();
+            trackKeypointsKlt(*prevFrame, frame, rois, c.kltWinSize, c.kltMaxLevel);
+            frame.stats.numMatches = frame.kptMatches.size();
+            frame.stats.matchTime = elapsedMs(t);
+            if (budget)
+            { // tracking is the part of the frame latency which grows with the no. of keypoints
+                budget->recordCost(frame.stats.matchTime, prevFrame->keypoints.size());
+            }
+            if (c.bVerbose)
+            {
+                cout << "# tracks: " << frame.kptMatches.size() << endl;
+                cout << "#4 : TRACK KEYPOINTS done in " << frame.stats.matchTime << " ms" << endl;
+            }
+        }
+
+        if (prevFrame == NULL || frame.keypoints.size() < (size_t)c.kltMinTracks)
+        { // the tracks keep their indices, new keypoints are appended where there is no track yet
+            vector<cv::KeyPoint> tracks, detected;
+            tracks.swap(frame.keypoints);
+            detectKeypoints(frame);
+            frame.stats.detectTime += frame.stats.pyramidTime;
+            detected.swap(frame.keypoints);
+            frame.keypoints.swap(tracks);
+            addNewKeypoints(frame, detected, c.kltMinDistance);
+        }
+        frame.stats.numKeypoints = frame.keypoints.size();
+
+        if (onFrame)
+        {
+            onFrame(prevFrame, frame);
+        }
+    };
+
+    /* MAIN LOOP OVER ALL IMAGES */
+
+    // in KLT mode there are no descriptors, detection moves into the tracking stage
+    // fused pairs describe their keypoints in the detect stage
+    typedef FramePipeline::FrameStage FrameStage;
+    typedef FramePipeline::MatchStage MatchStage;
+    FrameStage detectStage = c.bKlt ? FrameStage(trackingPyramid) : FrameStage(detectKeypoints);
+    FrameStage describeStage = c.bKlt || bFused ? FrameStage([](DataFrame &) {}) : FrameStage(describeKeypoints);
+    MatchStage matchStage = c.bKlt ? MatchStage(trackKeypoints) : MatchStage(matchKeypoints);
+
+    if (c.bPipelined)
+    { // frame N+1 is loaded and detected while frame N is described and matched
+        FramePipeline pipeline(c.dataBufferSize, c.pipelineQueueSize);
+        pipeline.setLoadStage(loadImage);
+        pipeline.setDetectStage(detectStage);
+        pipeline.setDescribeStage(describeStage);
+        pipeline.setMatchStage(matchStage);
+        pipeline.run();
+        if (c.bVerbose)
+        {
+            pipeline.printStats(cout);
+        }
+    }
+    else
+    {
+        DataFrameBuffer dataBuffer(c.dataBufferSize); // list of data frames which are held in memory at the same time
+        for (size_t imgIndex = 0; loadImage(dataBuffer.push(), imgIndex); imgIndex++)
+        {
+            // the frame just loaded into the oldest slot of the ring buffer
+            DataFrame &frame = dataBuffer.back();
+            detectStage(frame);
+            describeStage(frame);
+            matchStage(dataBuffer.size() > 1 ? &dataBuffer.back(1) : NULL, frame);
+        } // eof loop over all images
+    }
+
+    if (c.bVerbose)
+    {
+        AlgorithmRegistry::instance().printStats(cout);
+        if (c.matcherKind == MatcherKind::MAT_FLANN)
+        {
+            frameIndices.printStats(cout);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef tracker_hpp
+#define tracker_hpp
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "dataStructures.h"
+#include "featureTypes.hpp"
+#include "imageSource.hpp"
+
+
+struct TrackerConfig { // everything which determines a single run of the feature tracker
+
+    // image sequence
+    std::string imgBasePath = "../images/";
+    std::string imgPrefix = "KITTI/2011_09_26/image_00/data/000000"; // left camera, color
+    std::string imgFileType = ".png";
+    int imgStartIndex = 0; // first file index to load (assumes Lidar and camera names have identical naming convention)
+    int imgEndIndex = 9;   // last file index to load
+    int imgFillWidth = 4;  // no. of digits which make up the file index (e.g. img-0001.png)
+    std::string framePackFile; // pre-decoded frames written by writeFramePack, used instead of the image files if set
+
+    // algorithms, the descriptor data type (DES_BINARY, DES_HOG) follows from the descriptor
+    DetectorKind detectorKind = DetectorKind::FAST;        // SHITOMASI, HARRIS, FAST, BRISK, ORB, AKAZE, SIFT
+    DescriptorKind descriptorKind = DescriptorKind::BRIEF; // BRISK, BRIEF, ORB, FREAK, AKAZE, SIFT
+    MatcherKind matcherKind = MatcherKind::MAT_BF;         // MAT_BF, MAT_FLANN, MAT_GUIDED
+    SelectorKind selectorKind = SelectorKind::SEL_KNN;     // SEL_NN, SEL_KNN, SEL_MUTUAL, SEL_MUTUAL_KNN
+
+    // keypoint filtering
+    bool bFocusOnVehicle = true;                   // only detect keypoints on the preceding vehicle
+    std::vector<DetectionRoi> rois = {{cv::Rect(535, 180, 180, 150), 0}}; // regions searched when focusing, each with its own budget
+    RetentionKind retentionKind = RetentionKind::RET_BEST; // RET_BEST, RET_GRID, RET_SSC : which keypoints every budget keeps
+
+    // keypoint budget : the detector threshold of every ROI follows the keypoints it yielded in the previous frames,
+    // aiming at budgetKeypoints per ROI or, with budgetTimeMs > 0, at describing and matching a frame within that time
+    bool bKeypointBudget = false;
+    int budgetKeypoints = 50;
+    double budgetTimeMs = 0.0;
+
+    bool bTiledDetection = false;                  // split the image or ROIs into overlapping tiles detected in parallel
+    bool bFuseDetectDescribe = true;               // BRISK/BRISK, ORB/ORB, AKAZE/AKAZE and SIFT/SIFT detect and describe in the detect stage
+
+    // KLT mode : keypoints of the previous frame are tracked with pyramidal Lucas-Kanade instead of being
+    // detected, described and matched in every frame, the selected detector only runs when too few tracks survive
+    bool bKlt = false;
+    int kltMinTracks = 50;       // detect new keypoints once fewer tracks survive
+    int kltWinSize = 21;         // Lucas-Kanade window in pixels on every pyramid level
+    int kltMaxLevel = 3;         // no. of pyramid levels above the image
+    float kltMinDistance = 5.0f; // detected keypoints closer than this to a surviving track are dropped
+
+    // execution
+    int dataBufferSize = 2;    // no. of images which are held in memory (ring buffer) at the same time
+    bool bPipelined = true;    // run load, detection, description and matching of consecutive frames concurrently
+    int pipelineQueueSize = 2; // no. of frames which may wait in front of each pipeline stage
+    int readAheadFrames = 4;   // no. of images which are decoded ahead of the tracker
+    int decodeThreads = 2;     // no. of threads decoding images in the background
+    std::string indexDir;      // MAT_FLANN saves the search index of every frame here and loads it on later runs, disabled if empty
+    bool bVerbose = true;      // print progress of every stage
+};
+
+// called once per frame after matching, on the thread which called runTracker
+// prevFrame is null for the first frame of the sequence
+typedef std::function<void(DataFrame *prevFrame, DataFrame &frame)> FrameCallback;
+
+// image files of the configured sequence
+ImageSequence imageSequence(const TrackerConfig &config);
+
+// run detection, description and matching over the configured image sequence
+// the stages are selected before the first frame, an unsupported combination throws invalid_argument
+void runTracker(const TrackerConfig &config, const FrameCallback &onFrame);
+
+#endif /* tracker_hpp */
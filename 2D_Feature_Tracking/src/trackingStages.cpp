@@ -0,0 +1,90 @@
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "trackingStages.hpp"
+
+using namespace std;
+
+#if defined(TRACKER_DETECTOR) && defined(TRACKER_DESCRIPTOR) && defined(TRACKER_MATCHER) && defined(TRACKER_SELECTOR)
+
+// benchmark build : only the configured combination is instantiated, an invalid one fails to compile
+typedef TrackingStages<DetectorKind::TRACKER_DETECTOR, DescriptorKind::TRACKER_DESCRIPTOR,
+                       MatcherKind::TRACKER_MATCHER, SelectorKind::TRACKER_SELECTOR> BuiltStages;
+
+StageTable selectStages(DetectorKind detector, DescriptorKind descriptor, MatcherKind matcher, SelectorKind selector)
+{
+    if (detector != DetectorKind::TRACKER_DETECTOR || descriptor != DescriptorKind::TRACKER_DESCRIPTOR ||
+        matcher != MatcherKind::TRACKER_MATCHER || selector != SelectorKind::TRACKER_SELECTOR)
+    {
+        throw invalid_argument(string("this build only contains ") + toString(DetectorKind::TRACKER_DETECTOR) + "/" +
+                               toString(DescriptorKind::TRACKER_DESCRIPTOR) + "/" + toString(MatcherKind::TRACKER_MATCHER) + "/" +
+                               toString(SelectorKind::TRACKER_SELECTOR));
+    }
+    return BuiltStages::table();
+}
+
+#else
+
+// all combinations are enumerated at compile time, combination I decodes into the four kinds below
+const int NUM_COMBINATIONS = NUM_DETECTOR_KINDS * NUM_DESCRIPTOR_KINDS * NUM_MATCHER_KINDS * NUM_SELECTOR_KINDS;
+
+static int combinationIndex(DetectorKind detector, DescriptorKind descriptor, MatcherKind matcher, SelectorKind selector)
+{
+    return ((static_cast<int>(detector) * NUM_DESCRIPTOR_KINDS + static_cast<int>(descriptor)) * NUM_MATCHER_KINDS +
+            static_cast<int>(matcher)) * NUM_SELECTOR_KINDS + static_cast<int>(selector);
+}
+
+template <int I>
+struct Combination {
+    static constexpr DetectorKind detector = static_cast<DetectorKind>(I / (NUM_DESCRIPTOR_KINDS * NUM_MATCHER_KINDS * NUM_SELECTOR_KINDS));
+    static constexpr DescriptorKind descriptor = static_cast<DescriptorKind>(I / (NUM_MATCHER_KINDS * NUM_SELECTOR_KINDS) % NUM_DESCRIPTOR_KINDS);
+    static constexpr MatcherKind matcher = static_cast<MatcherKind>(I / NUM_SELECTOR_KINDS % NUM_MATCHER_KINDS);
+    static constexpr SelectorKind selector = static_cast<SelectorKind>(I % NUM_SELECTOR_KINDS);
+    static constexpr bool valid = isValidCombination(detector, descriptor);
+};
+
+template <int I>
+static typename enable_if<Combination<I>::valid, StageTable>::type stageTableEntry()
+{
+    return TrackingStages<Combination<I>::detector, Combination<I>::descriptor,
+                          Combination<I>::matcher, Combination<I>::selector>::table();
+}
+
+template <int I>
+static typename enable_if<!Combination<I>::valid, StageTable>::type stageTableEntry()
+{
+    StageTable stages = {NULL, NULL, NULL, NULL};
+    return stages;
+}
+
+template <int... Is>
+struct IndexList {};
+
+template <int N, int... Is>
+struct MakeIndexList : MakeIndexList<N - 1, N - 1, Is...> {};
+
+template <int... Is>
+struct MakeIndexList<0, Is...> {
+    typedef IndexList<Is...> type;
+};
+
+template <int... Is>
+static const StageTable *allStageTables(IndexList<Is...>)
+{
+    static const StageTable tables[] = {stageTableEntry<Is>()...};
+    return tables;
+}
+
+StageTable selectStages(DetectorKind detector, DescriptorKind descriptor, MatcherKind matcher, SelectorKind selector)
+{
+    const StageTable *tables = allStageTables(MakeIndexList<NUM_COMBINATIONS>::type());
+    const StageTable &stages = tables[combinationIndex(detector, descriptor, matcher, selector)];
+    if (stages.detect == NULL)
+    {
+        throw invalid_argument(string(toString(detector)) + " keypoints cannot be described with " + toString(descriptor));
+    }
+    return stages;
+}
+
+#endif
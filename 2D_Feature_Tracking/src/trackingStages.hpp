@@ -0,0 +1,180 @@
+#ifndef trackingStages_hpp
+#define trackingStages_hpp
+
+#include <vector>
+
+#include "dataStructures.h"
+#include "featureTypes.hpp"
+#include "matching2D.hpp"
+#include "frameIndex.hpp"
+#include "framePyramid.hpp"
+
+
+struct StageTable { // stage functions of one detector / descriptor / matcher / selector combination
+    void (*detect)(DataFrame &frame, const std::vector<DetectionRoi> &rois); // empty rois = whole image
+    void (*describe)(DataFrame &frame);
+    void (*match)(DataFrame &prevFrame, DataFrame &frame, FrameIndexMatcher &frameIndices);
+    void (*detectAndDescribe)(DataFrame &frame, const std::vector<DetectionRoi> &rois); // fused pairs only, NULL otherwise
+};
+
+
+template <DetectorKind D>
+struct KeypointDetection { // detectors backed by an OpenCV feature detector object
+    static void run(DataFrame &frame) { detKeypointsModern(frame.keypoints, frame.cameraImg, D); }
+};
+
+template <>
+struct KeypointDetection<DetectorKind::SHITOMASI> {
+    static void run(DataFrame &frame) { detKeypointsShiTomasi(frame.keypoints, frame.cameraImg); }
+};
+
+template <>
+struct KeypointDetection<DetectorKind::HARRIS> {
+    static void run(DataFrame &frame) { detKeypointsHarris(frame.keypoints, frame.cameraImg); }
+};
+
+template <DetectorKind D>
+inline void detectInRois(DataFrame &frame, const std::vector<DetectionRoi> &rois)
+{
+    if (rois.empty())
+    {
+        KeypointDetection<D>::run(frame);
+    }
+    else
+    { // detection cost scales with the ROI area instead of the frame area
+        detKeypointsRoi(frame.keypoints, frame.cameraImg, rois, D);
+    }
+}
+
+template <>
+inline void detectInRois<DetectorKind::ORB>(DataFrame &frame, const std::vector<DetectionRoi> &rois)
+{
+    if (hasPyramid(frame, ORB_PYRAMID))
+    { // the levels come from the pyramid which the detect stage built for this frame
+        detKeypointsOrbPyramid(frame.keypoints, frame, rois);
+    }
+    else if (rois.empty())
+    {
+        KeypointDetection<DetectorKind::ORB>::run(frame);
+    }
+    else
+    {
+        detKeypointsRoi(frame.keypoints, frame.cameraImg, rois, DetectorKind::ORB);
+    }
+}
+
+
+template <DescriptorKind X>
+struct KeypointDescription { // extractors which build whatever scale space they need inside compute
+    static void run(DataFrame &frame) { descKeypoints(frame.keypoints, frame.cameraImg, frame.descriptors, X); }
+};
+
+template <>
+struct KeypointDescription<DescriptorKind::ORB> {
+    static void run(DataFrame &frame)
+    {
+        if (hasPyramid(frame, ORB_PYRAMID))
+        {
+            descKeypointsOrbPyramid(frame.keypoints, frame, frame.descriptors);
+        }
+        else
+        {
+            descKeypoints(frame.keypoints, frame.cameraImg, frame.descriptors, DescriptorKind::ORB);
+        }
+    }
+};
+
+
+template <DetectorKind D>
+struct FusedExtraction { // detector objects which also describe their keypoints, see isFusedCombination
+    static void run(DataFrame &frame, const std::vector<DetectionRoi> &rois)
+    {
+        detectAndDescribe(frame.keypoints, frame.cameraImg, frame.descriptors, rois, D);
+    }
+};
+
+template <>
+struct FusedExtraction<DetectorKind::ORB> {
+    // with the frame pyramid both phases read the same cached levels, so the ROI budgets are applied in between
+    // and only the kept keypoints are described
+    static void run(DataFrame &frame, const std::vector<DetectionRoi> &rois)
+    {
+        if (hasPyramid(frame, ORB_PYRAMID))
+        {
+            detKeypointsOrbPyramid(frame.keypoints, frame, rois);
+            descKeypointsOrbPyramid(frame.keypoints, frame, frame.descriptors);
+        }
+        else
+        {
+            detectAndDescribe(frame.keypoints, frame.cameraImg, frame.descriptors, rois, DetectorKind::ORB);
+        }
+    }
+};
+
+
+template <MatcherKind M>
+struct DescriptorMatching { // matchers which search all keypoints of the current frame
+    static void run(DataFrame &prevFrame, DataFrame &frame, FrameIndexMatcher &, DescriptorDataKind descriptorDataKind,
+                    SelectorKind selectorKind)
+    {
+        matchDescriptors(prevFrame.keypoints, frame.keypoints, prevFrame.descriptors, frame.descriptors,
+                         frame.kptMatches, descriptorDataKind, M, selectorKind);
+    }
+};
+
+template <>
+struct DescriptorMatching<MatcherKind::MAT_FLANN> {
+    // the index of a frame is built once, when it is the current frame, and searched again one frame later
+    // by the reverse search of the mutual selectors
+    static void run(DataFrame &prevFrame, DataFrame &frame, FrameIndexMatcher &frameIndices, DescriptorDataKind descriptorDataKind,
+                    SelectorKind selectorKind)
+    {
+        frameIndices.match(prevFrame, frame, descriptorDataKind, selectorKind);
+    }
+};
+
+template <>
+struct DescriptorMatching<MatcherKind::MAT_GUIDED> {
+    // keypoints are predicted with the motion of the previous frame pair (constant velocity),
+    // the motion of this pair is estimated from the matches for the next frame
+    static void run(DataFrame &prevFrame, DataFrame &frame, FrameIndexMatcher &, DescriptorDataKind descriptorDataKind,
+                    SelectorKind selectorKind)
+    {
+        float searchRadius = prevFrame.motion.empty() ? GUIDED_SEARCH_RADIUS_NO_PRIOR : GUIDED_SEARCH_RADIUS;
+        matchDescriptorsGuided(prevFrame.keypoints, frame.keypoints, prevFrame.descriptors, frame.descriptors,
+                               frame.kptMatches, descriptorDataKind, selectorKind, prevFrame.motion, searchRadius);
+        frame.motion = estimateMotion(prevFrame.keypoints, frame.keypoints, frame.kptMatches);
+    }
+};
+
+
+// the algorithm selection is a compile-time constant in every stage, so no string is compared per frame
+// and the descriptor data type used for matching always follows from the descriptor
+template <DetectorKind D, DescriptorKind X, MatcherKind M, SelectorKind S>
+struct TrackingStages {
+    static_assert(isValidCombination(D, X), "detector / descriptor combination is not supported by OpenCV");
+
+    static void detect(DataFrame &frame, const std::vector<DetectionRoi> &rois) { detectInRois<D>(frame, rois); }
+
+    static void describe(DataFrame &frame) { KeypointDescription<X>::run(frame); }
+
+    static void match(DataFrame &prevFrame, DataFrame &frame, FrameIndexMatcher &frameIndices)
+    {
+        DescriptorMatching<M>::run(prevFrame, frame, frameIndices, descriptorDataKindOf(X), S);
+    }
+
+    static void detectAndDescribe(DataFrame &frame, const std::vector<DetectionRoi> &rois) { FusedExtraction<D>::run(frame, rois); }
+
+    static StageTable table()
+    {
+        StageTable stages = {&detect, &describe, &match, isFusedCombination(D, X) ? &detectAndDescribe : NULL};
+        return stages;
+    }
+};
+
+
+// prebuilt stages for the given combination, selected once at startup
+// throws invalid_argument for combinations which are invalid or not part of this build
+StageTable selectStages(DetectorKind detector, DescriptorKind descriptor, MatcherKind matcher, SelectorKind selector);
+
+#endif /* trackingStages_hpp */
@@ -7,6 +7,8 @@
 #include <opencv2/features2d.hpp>
 #include <opencv2/xfeatures2d.hpp>
 
+#include "harrisEngine.hpp"
+
 
 void DetectCorners(std::string input_filename)
 {
@@ -17,15 +19,13 @@ void DetectCorners(std::string input_filename)
 
     // Detector parameters
     int blockSize = 2;     // for every pixel, a blockSize × blockSize neighborhood is considered
-    int apertureSize = 3;  // aperture parameter for Sobel operator (must be odd)
-    int minResponse = 100; // minimum value for a corner in the 8bit scaled response matrix
-    double k = 0.04;       // Harris parameter (see equation for details)
-
-    // Detect Harris corners and normalize output
-    cv::Mat dst, dst_norm, dst_norm_scaled;
-    dst = cv::Mat::zeros(img.size(), CV_32FC1);
-    cv::cornerHarris(img, dst, blockSize, apertureSize, k, cv::BORDER_DEFAULT);
-    cv::normalize(dst, dst_norm, 0, 255, cv::NORM_MINMAX, CV_32FC1, cv::Mat());
+    double k = 0.04;       // Harris parameter (see equation for details), the Sobel aperture is 3
+
+    // Detect Harris corners in a single pass and normalize output
+    HarrisEngine harris(blockSize, k);
+    harris.compute(img);
+    cv::Mat dst_norm, dst_norm_scaled;
+    harris.normalized(dst_norm);
     cv::convertScaleAbs(dst_norm, dst_norm_scaled);
 
     // save result to file
@@ -0,0 +1,372 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+#include "hammingMatcher.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAMMING_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// nearest query of every train row, updated by the kernels unless dist is null
+struct ColumnBest {
+    int *dist;
+    int *idx;
+    int query; // index of the query passed to the kernel
+};
+
+// kernel interface : best and second best distance of one query over all train rows, rows are chunks * 32 bytes long
+typedef void (*Top2Kernel)(const uint64_t *query, const uint64_t *train, int numTrain, int chunks,
+                           int &bestIdx, int &best, int &second, const ColumnBest &col);
+
+static inline void updateTop2(int d, int idx, int &bestIdx, int &best, int &second)
+{ // strict comparisons, so the first of several equal train rows wins as in cv::BFMatcher
+    if (d < best)
+    {
+        second = best;
+        best = d;
+        bestIdx = idx;
+    }
+    else if (d < second)
+    {
+        second = d;
+    }
+}
+
+static inline void updateColumn(int d, int idx, const ColumnBest &col)
+{ // queries arrive in increasing order, so the first of several equally near queries is kept
+    if (col.dist && d < col.dist[idx])
+    {
+        col.dist[idx] = d;
+        col.idx[idx] = col.query;
+    }
+}
+
+// portable kernel, also compiled with POPCNT enabled below
+template<int CHUNKS>
+static inline __attribute__((always_inline)) void top2Portable(const uint64_t *query, const uint64_t *train, int numTrain, int chunks,
+                                                               int &bestIdx, int &best, int &second, const ColumnBest &col)
+{
+    const int words = 4 * (CHUNKS > 0 ? CHUNKS : chunks);
+    int b = INT_MAX, s = INT_MAX, bi = -1;
+    for (int t = 0; t < numTrain; ++t, train += words)
+    {
+        int d = 0;
+        for (int w = 0; w < words; ++w)
+        {
+            d += __builtin_popcountll(query[w] ^ train[w]);
+        }
+        updateTop2(d, t, bi, b, s);
+        updateColumn(d, t, col);
+    }
+    bestIdx = bi;
+    best = b;
+    second = s;
+}
+
+template<int CHUNKS>
+static void top2Scalar(const uint64_t *query, const uint64_t *train, int numTrain, int chunks, int &bestIdx, int &best, int &second,
+                       const ColumnBest &col)
+{
+    top2Portable<CHUNKS>(query, train, numTrain, chunks, bestIdx, best, second, col);
+}
+
+#ifdef HAMMING_X86
+
+template<int CHUNKS>
+__attribute__((target("popcnt"))) static void top2Popcnt(const uint64_t *query, const uint64_t *train, int numTrain, int chunks,
+                                                         int &bestIdx, int &best, int &second, const ColumnBest &col)
+{
+    top2Portable<CHUNKS>(query, train, numTrain, chunks, bestIdx, best, second, col);
+}
+
+// distances of four train rows from their per-row 64-bit partial sums
+__attribute__((target("avx2"))) static inline __m128i reduce4(__m256i a, __m256i b, __m256i c, __m256i d)
+{
+    // partial sums are small, so two rows share a 64-bit lane : [a0 b0 a1 b1 | a2 b2 a3 b3]
+    __m256i ab = _mm256_or_si256(a, _mm256_slli_epi64(b, 32));
+    __m256i cd = _mm256_or_si256(c, _mm256_slli_epi64(d, 32));
+    ab = _mm256_add_epi32(ab, _mm256_shuffle_epi32(ab, _MM_SHUFFLE(1, 0, 3, 2))); // [a0+a1 b0+b1 . . | a2+a3 b2+b3 . .]
+    cd = _mm256_add_epi32(cd, _mm256_shuffle_epi32(cd, _MM_SHUFFLE(1, 0, 3, 2)));
+    __m256i abcd = _mm256_unpacklo_epi64(ab, cd);
+    return _mm_add_epi32(_mm256_castsi256_si128(abcd), _mm256_extracti128_si256(abcd, 1));
+}
+
+// top-2 update of four consecutive train rows, most blocks have no distance below the second best and are skipped
+__attribute__((target("avx2"))) static inline void updateTop2x4(__m128i dist, int t, int &bestIdx, int &best, int &second)
+{
+    if (_mm_movemask_epi8(_mm_cmplt_epi32(dist, _mm_set1_epi32(second))) == 0)
+    {
+        return;
+    }
+    int d[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(d), dist);
+    for (int k = 0; k < 4; ++k)
+    {
+        updateTop2(d[k], t + k, bestIdx, best, second);
+    }
+}
+
+// column update of four consecutive train rows
+__attribute__((target("avx2"))) static inline void updateColumn4(__m128i dist, int t, const ColumnBest &col)
+{
+    if (!col.dist)
+    {
+        return;
+    }
+    __m128i *colDist = reinterpret_cast<__m128i *>(col.dist + t), *colIdx = reinterpret_cast<__m128i *>(col.idx + t);
+    __m128i current = _mm_loadu_si128(colDist);
+    __m128i closer = _mm_cmplt_epi32(dist, current);
+    _mm_storeu_si128(colDist, _mm_blendv_epi8(current, dist, closer));
+    _mm_storeu_si128(colIdx, _mm_blendv_epi8(_mm_loadu_si128(colIdx), _mm_set1_epi32(col.query), closer));
+}
+
+// popcount by 4-bit table lookup, per-byte counts are summed into the four 64-bit lanes
+__attribute__((target("avx2"))) static inline __m256i popcountAvx2(__m256i v)
+{
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowNibble = _mm256_set1_epi8(0x0f);
+    __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, lowNibble));
+    __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibble));
+    return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+}
+
+template<int CHUNKS>
+__attribute__((target("avx2"))) static inline __m256i distanceAvx2(const __m256i *q, const uint64_t *t, int chunks)
+{
+    const int n = CHUNKS > 0 ? CHUNKS : chunks;
+    const __m256i *row = reinterpret_cast<const __m256i *>(t);
+    __m256i acc = popcountAvx2(_mm256_xor_si256(q[0], _mm256_loadu_si256(row)));
+    for (int c = 1; c < n; ++c)
+    {
+        acc = _mm256_add_epi64(acc, popcountAvx2(_mm256_xor_si256(q[c], _mm256_loadu_si256(row + c))));
+    }
+    return acc;
+}
+
+template<int CHUNKS>
+__attribute__((target("avx2"))) static void top2Avx2(const uint64_t *query, const uint64_t *train, int numTrain, int chunks,
+                                                     int &bestIdx, int &best, int &second, const ColumnBest &col)
+{
+    const int n = CHUNKS > 0 ? CHUNKS : chunks;
+    const int words = 4 * n;
+    __m256i q[CHUNKS > 0 ? CHUNKS : 8];
+    for (int c = 0; c < n; ++c)
+    {
+        q[c] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(query) + c);
+    }
+
+    int b = INT_MAX, s = INT_MAX, bi = -1;
+    int t = 0;
+    for (; t + 4 <= numTrain; t += 4, train += 4 * words)
+    {
+        __m128i dist = reduce4(distanceAvx2<CHUNKS>(q, train, n), distanceAvx2<CHUNKS>(q, train + words, n),
+                               distanceAvx2<CHUNKS>(q, train + 2 * words, n), distanceAvx2<CHUNKS>(q, train + 3 * words, n));
+        updateTop2x4(dist, t, bi, b, s);
+        updateColumn4(dist, t, col);
+    }
+    for (; t < numTrain; ++t, train += words)
+    {
+        __m256i z = _mm256_setzero_si256();
+        int d = _mm_cvtsi128_si32(reduce4(distanceAvx2<CHUNKS>(q, train, n), z, z, z));
+        updateTop2(d, t, bi, b, s);
+        updateColumn(d, t, col);
+    }
+    bestIdx = bi;
+    best = b;
+    second = s;
+}
+
+#define HAMMING_AVX512 "avx2,avx512f,avx512vl,avx512vpopcntdq"
+
+template<int CHUNKS>
+__attribute__((target(HAMMING_AVX512))) static inline __m256i distanceVpopcnt(const __m256i *q, const uint64_t *t, int chunks)
+{
+    const int n = CHUNKS > 0 ? CHUNKS : chunks;
+    const __m256i *row = reinterpret_cast<const __m256i *>(t);
+    __m256i acc = _mm256_popcnt_epi64(_mm256_xor_si256(q[0], _mm256_loadu_si256(row)));
+    for (int c = 1; c < n; ++c)
+    {
+        acc = _mm256_add_epi64(acc, _mm256_popcnt_epi64(_mm256_xor_si256(q[c], _mm256_loadu_si256(row + c))));
+    }
+    return acc;
+}
+
+template<int CHUNKS>
+__attribute__((target(HAMMING_AVX512))) static void top2Vpopcnt(const uint64_t *query, const uint64_t *train, int numTrain, int chunks,
+                                                                int &bestIdx, int &best, int &second, const ColumnBest &col)
+{
+    const int n = CHUNKS > 0 ? CHUNKS : chunks;
+    const int words = 4 * n;
+    __m256i q[CHUNKS > 0 ? CHUNKS : 8];
+    for (int c = 0; c < n; ++c)
+    {
+        q[c] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(query) + c);
+    }
+
+    int b = INT_MAX, s = INT_MAX, bi = -1;
+    int t = 0;
+    for (; t + 4 <= numTrain; t += 4, train += 4 * words)
+    {
+        __m128i dist = reduce4(distanceVpopcnt<CHUNKS>(q, train, n), distanceVpopcnt<CHUNKS>(q, train + words, n),
+                               distanceVpopcnt<CHUNKS>(q, train + 2 * words, n), distanceVpopcnt<CHUNKS>(q, train + 3 * words, n));
+        updateTop2x4(dist, t, bi, b, s);
+        updateColumn4(dist, t, col);
+    }
+    for (; t < numTrain; ++t, train += words)
+    {
+        __m256i z = _mm256_setzero_si256();
+        int d = _mm_cvtsi128_si32(reduce4(distanceVpopcnt<CHUNKS>(q, train, n), z, z, z));
+        updateTop2(d, t, bi, b, s);
+        updateColumn(d, t, col);
+    }
+    bestIdx = bi;
+    best = b;
+    second = s;
+}
+
+#endif /* HAMMING_X86 */
+
+// kernels for rows of 1 chunk (ORB, BRIEF-32) and 2 chunks (BRISK, FREAK, AKAZE, BRIEF-64), any other length
+// uses the generic instance, the SIMD kernels keep the query in at most 8 registers (256 bytes)
+struct KernelSet {
+    const char *name;
+    Top2Kernel oneChunk, twoChunks, generic;
+    int maxChunks;
+};
+
+static const KernelSet &kernels()
+{
+    static const KernelSet selected = []() {
+#ifdef HAMMING_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512vpopcntdq") && __builtin_cpu_supports("avx512vl"))
+        {
+            return KernelSet{"avx512-vpopcntdq", top2Vpopcnt<1>, top2Vpopcnt<2>, top2Vpopcnt<0>, 8};
+        }
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return KernelSet{"avx2", top2Avx2<1>, top2Avx2<2>, top2Avx2<0>, 8};
+        }
+        if (__builtin_cpu_supports("popcnt"))
+        {
+            return KernelSet{"popcnt", top2Popcnt<1>, top2Popcnt<2>, top2Popcnt<0>, INT_MAX};
+        }
+#endif
+        return KernelSet{"portable", top2Scalar<1>, top2Scalar<2>, top2Scalar<0>, INT_MAX};
+    }();
+    return selected;
+}
+
+const char *HammingMatcher::kernelName()
+{
+    return kernels().name;
+}
+
+HammingMatcher::HammingMatcher()
+{
+}
+
+void HammingMatcher::pad(const cv::Mat &desc, int chunks, vector<uint64_t> &dst) const
+{
+    const size_t words = 4 * chunks;
+    dst.assign(words * desc.rows, 0);
+    for (int r = 0; r < desc.rows; ++r)
+    {
+        memcpy(&dst[words * r], desc.ptr<uchar>(r), desc.cols);
+    }
+}
+
+void HammingMatcher::match(const cv::Mat &query, const cv::Mat &train, double maxRatio, bool bMutual, vector<cv::DMatch> &matches,
+                           ThreadPool *pool)
+{
+    matches.clear();
+    if (query.empty() || train.empty())
+    {
+        return;
+    }
+    if (query.type() != CV_8UC1 || train.type() != CV_8UC1 || query.cols != train.cols)
+    {
+        throw invalid_argument("HammingMatcher : descriptors must be CV_8UC1 rows of equal length");
+    }
+    bool bRatio = maxRatio > 0;
+    if (bRatio && train.rows < 2)
+    { // knnMatch would return a single neighbor, which never passes the ratio test
+        return;
+    }
+
+    const KernelSet &k = kernels();
+    const int chunks = (query.cols + CHUNK - 1) / CHUNK;
+    if (chunks > k.maxChunks)
+    {
+        throw invalid_argument("HammingMatcher : descriptors longer than 256 bytes are not supported");
+    }
+    Top2Kernel kernel = chunks == 1 ? k.oneChunk : (chunks == 2 ? k.twoChunks : k.generic);
+    pad(query, chunks, queryRows);
+    pad(train, chunks, trainRows);
+
+    // queries are split into chunks of fixed size, each chunk keeps its own nearest query per train descriptor,
+    // so the result does not depend on how the chunks are spread over threads
+    const int numChunks = (query.rows + QUERY_CHUNK - 1) / QUERY_CHUNK;
+    if (bMutual)
+    {
+        colBest.assign(static_cast<size_t>(numChunks) * train.rows, INT_MAX);
+        colBestIdx.assign(static_cast<size_t>(numChunks) * train.rows, -1);
+    }
+
+    // one slot per query, trainIdx -1 marks a rejected query
+    matches.resize(query.rows);
+    const size_t words = 4 * chunks;
+    auto matchChunk = [&](int c) {
+        ColumnBest col = {NULL, NULL, 0};
+        if (bMutual)
+        {
+            col.dist = &colBest[static_cast<size_t>(c) * train.rows];
+            col.idx = &colBestIdx[static_cast<size_t>(c) * train.rows];
+        }
+        for (int i = c * QUERY_CHUNK; i < min(query.rows, (c + 1) * QUERY_CHUNK); ++i)
+        {
+            int bestIdx, best, second;
+            col.query = i;
+            kernel(&queryRows[words * i], trainRows.data(), train.rows, chunks, bestIdx, best, second, col);
+            bool bPass = !bRatio || best < maxRatio * second;
+            matches[i] = cv::DMatch(i, bPass ? bestIdx : -1, static_cast<float>(best));
+        }
+    };
+    if (pool)
+    {
+        pool->parallelFor(numChunks, matchChunk);
+    }
+    else
+    {
+        for (int c = 0; c < numChunks; ++c)
+        {
+            matchChunk(c);
+        }
+    }
+
+    // chunks are merged in query order, so equally near queries resolve to the first one
+    for (int c = 1; bMutual && c < numChunks; ++c)
+    {
+        const int *dist = &colBest[static_cast<size_t>(c) * train.rows];
+        const int *idx = &colBestIdx[static_cast<size_t>(c) * train.rows];
+        for (int j = 0; j < train.rows; ++j)
+        {
+            if (dist[j] < colBest[j])
+            {
+                colBest[j] = dist[j];
+                colBestIdx[j] = idx[j];
+            }
+        }
+    }
+
+    auto end = remove_if(matches.begin(), matches.end(), [&](const cv::DMatch &m) {
+        return m.trainIdx < 0 || (bMutual && colBestIdx[m.trainIdx] != m.queryIdx);
+    });
+    matches.erase(end, matches.end());
+}
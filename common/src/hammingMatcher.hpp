@@ -0,0 +1,44 @@
+#ifndef hammingMatcher_hpp
+#define hammingMatcher_hpp
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "threadPool.hpp"
+
+
+// brute-force matching of binary descriptors (BRIEF, ORB, BRISK, FREAK, AKAZE) under the Hamming distance
+// both sets are copied into rows padded with zeros to a multiple of 32 bytes, the distance kernel
+// keeps the best and second best distance of a query in registers while it runs over all train descriptors,
+// the nearest query of every train descriptor is updated in the same pass for cross-checking
+// the kernel is chosen at run time : AVX-512 VPOPCNTDQ, AVX2 nibble lookup, POPCNT or portable popcount
+class HammingMatcher
+{
+public:
+    HammingMatcher();
+
+    // query and train are CV_8UC1 with one descriptor per row and the same no. of columns, throws invalid_argument otherwise
+    // maxRatio <= 0 : nearest neighbor of every query, same result as cv::BFMatcher(NORM_HAMMING).match
+    // maxRatio > 0  : nearest neighbor of the queries which pass best < maxRatio * second best, same result as
+    //                 knnMatch with k = 2 followed by the ratio test, a query with a single train candidate is dropped
+    // bMutual       : additionally drop a match unless the query is also the nearest neighbor of its train descriptor,
+    //                 with maxRatio <= 0 the same result as cv::BFMatcher(NORM_HAMMING, true).match
+    // matches is resized to hold a result for every query and shrunk afterwards, its capacity is kept across calls
+    // with a pool, chunks of queries are matched in parallel, the result is the same for any no. of threads
+    void match(const cv::Mat &query, const cv::Mat &train, double maxRatio, bool bMutual, std::vector<cv::DMatch> &matches,
+               ThreadPool *pool = NULL);
+
+    static const char *kernelName(); // kernel selected for this CPU
+
+private:
+    static const int CHUNK = 32;       // bytes per kernel step
+    static const int QUERY_CHUNK = 64; // queries per parallel task, their padded rows stay in L1
+
+    void pad(const cv::Mat &desc, int chunks, std::vector<uint64_t> &dst) const;
+
+    std::vector<uint64_t> queryRows, trainRows; // padded copies of the last call, reused to avoid allocations
+    std::vector<int> colBest, colBestIdx;       // nearest query of every train descriptor, one set per chunk of queries
+};
+
+#endif /* hammingMatcher_hpp */
@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <cfloat>
+#include <stdexcept>
+#include <opencv2/core/hal/intrin.hpp>
+
+#include "harrisEngine.hpp"
+
+using namespace std;
+
+HarrisEngine::HarrisEngine(int blockSize, double k) : blockSize(blockSize), k((float)k), minResp(0.0f), maxResp(0.0f)
+{
+    if (blockSize < 1 || blockSize > 3)
+    { // box sums of up to 3x3 squared 8-bit gradients are exact in float
+        throw invalid_argument("HarrisEngine supports block sizes 1 to 3");
+    }
+    double scale = 1.0 / (4 * blockSize * 255); // (1 << (apertureSize - 1)) * blockSize * 255 as in cv::cornerHarris
+    scaleSq = (float)(scale * scale);
+}
+
+// split [0, len) into parts of at most maxPart, all of about the same size
+static void splitRange(int len, int maxPart, vector<int> &borders)
+{
+    int parts = (len + maxPart - 1) / maxPart;
+    borders.resize(parts + 1);
+    for (int i = 0; i <= parts; ++i)
+    {
+        borders[i] = (int)((long long)len * i / parts);
+    }
+}
+
+void HarrisEngine::compute(const cv::Mat &img)
+{
+    if (img.type() != CV_8UC1 || img.rows <= blockSize || img.cols <= blockSize || img.rows < 3 || img.cols < 3)
+    {
+        throw invalid_argument("HarrisEngine expects a CV_8UC1 image of at least 3x3 pixels");
+    }
+
+    responseImg.create(img.rows, img.cols, CV_32FC1);
+    splitRange(img.cols, TILE_COLS, tileX);
+    splitRange(img.rows, TILE_ROWS, tileY);
+    int tilesX = tileX.size() - 1, tilesY = tileY.size() - 1;
+    tileMax.resize(tilesX * tilesY);
+
+    minResp = FLT_MAX;
+    maxResp = -FLT_MAX;
+    for (int ty = 0; ty < tilesY; ++ty)
+    {
+        for (int tx = 0; tx < tilesX; ++tx)
+        {
+            float tMin, tMax;
+            computeTile(img, tileX[tx], tileY[ty], tileX[tx + 1], tileY[ty + 1], tMin, tMax);
+            tileMax[ty * tilesX + tx] = tMax;
+            minResp = min(minResp, tMin);
+            maxResp = max(maxResp, tMax);
+        }
+    }
+}
+
+void HarrisEngine::computeTile(const cv::Mat &img, int x0, int y0, int x1, int y1, float &tileMin, float &tileMax)
+{
+    const int rows = img.rows, cols = img.cols;
+
+    // the box filter of cv::cornerHarris sums products at [x - anchor, x - anchor + blockSize), same for y,
+    // products outside the image are reflected (BORDER_REFLECT_101), they are not computed from reflected pixels
+    const int anchor = blockSize / 2;
+    const int pr0 = y0 - anchor, pc0 = x0 - anchor;                              // first product row / col of the tile
+    const int ph = y1 - y0 + blockSize - 1, pw = x1 - x0 + blockSize - 1;        // size of the product buffers
+    const int ir0 = max(pr0, 0), ir1 = min(pr0 + ph, rows);                       // product rows inside the image
+    const int ic0 = max(pc0, 0), ic1 = min(pc0 + pw, cols);                       // product cols inside the image
+
+    /* PIXELS */
+
+    // 8-bit pixels around the products as float, with a reflected one-pixel border for the Sobel operator
+    const int nw = ic1 - ic0 + 2, nh = ir1 - ir0 + 2;
+    pixels.resize(nw * nh);
+    for (int r = 0; r < nh; ++r)
+    {
+        const uchar *src = img.ptr<uchar>(cv::borderInterpolate(ir0 - 1 + r, rows, cv::BORDER_REFLECT_101));
+        float *dst = &pixels[r * nw];
+        dst[0] = src[cv::borderInterpolate(ic0 - 1, cols, cv::BORDER_REFLECT_101)];
+        for (int c = 1; c < nw - 1; ++c)
+        {
+            dst[c] = src[ic0 - 1 + c];
+        }
+        dst[nw - 1] = src[cv::borderInterpolate(ic1, cols, cv::BORDER_REFLECT_101)];
+    }
+
+    /* GRADIENTS AND STRUCTURE TENSOR PRODUCTS */
+
+    // integer-valued in float : gradients of 8-bit images and their products are exact
+    prodA.resize(ph * pw);
+    prodB.resize(ph * pw);
+    prodC.resize(ph * pw);
+    const int n = ic1 - ic0;
+    for (int r = ir0; r < ir1; ++r)
+    {
+        const float *above = &pixels[(r - ir0) * nw + 1], *center = above + nw, *below = center + nw;
+        int offset = (r - pr0) * pw + (ic0 - pc0);
+        float *a = &prodA[offset], *b = &prodB[offset], *c = &prodC[offset];
+
+        int x = 0;
+#if CV_SIMD
+        const cv::v_float32 two = cv::vx_setall_f32(2.0f);
+        for (; x <= n - cv::v_float32::nlanes; x += cv::v_float32::nlanes)
+        {
+            cv::v_float32 aboveL = cv::vx_load(above + x - 1), aboveC = cv::vx_load(above + x), aboveR = cv::vx_load(above + x + 1);
+            cv::v_float32 centerL = cv::vx_load(center + x - 1), centerR = cv::vx_load(center + x + 1);
+            cv::v_float32 belowL = cv::vx_load(below + x - 1), belowC = cv::vx_load(below + x), belowR = cv::vx_load(below + x + 1);
+
+            cv::v_float32 dx = (aboveR - aboveL) + two * (centerR - centerL) + (belowR - belowL);
+            cv::v_float32 dy = (belowL + two * belowC + belowR) - (aboveL + two * aboveC + aboveR);
+            cv::v_store(a + x, dx * dx);
+            cv::v_store(b + x, dx * dy);
+            cv::v_store(c + x, dy * dy);
+        }
+#endif
+        for (; x < n; ++x)
+        {
+            float dx = (above[x + 1] - above[x - 1]) + 2.0f * (center[x + 1] - center[x - 1]) + (below[x + 1] - below[x - 1]);
+            float dy = (below[x - 1] + 2.0f * below[x] + below[x + 1]) - (above[x - 1] + 2.0f * above[x] + above[x + 1]);
+            a[x] = dx * dx;
+            b[x] = dx * dy;
+            c[x] = dy * dy;
+        }
+    }
+
+    // products outside the image, columns of the computed rows first, then whole rows
+    for (int r = ir0; r < ir1; ++r)
+    {
+        int row = (r - pr0) * pw;
+        for (int j = 0; j < pw; ++j)
+        {
+            int col = pc0 + j;
+            if (col < 0 || col >= cols)
+            {
+                int src = row + cv::borderInterpolate(col, cols, cv::BORDER_REFLECT_101) - pc0;
+                prodA[row + j] = prodA[src];
+                prodB[row + j] = prodB[src];
+                prodC[row + j] = prodC[src];
+            }
+        }
+    }
+    for (int i = 0; i < ph; ++i)
+    {
+        int r = pr0 + i;
+        if (r < 0 || r >= rows)
+        {
+            int src = (cv::borderInterpolate(r, rows, cv::BORDER_REFLECT_101) - pr0) * pw;
+            copy(prodA.begin() + src, prodA.begin() + src + pw, prodA.begin() + i * pw);
+            copy(prodB.begin() + src, prodB.begin() + src + pw, prodB.begin() + i * pw);
+            copy(prodC.begin() + src, prodC.begin() + src + pw, prodC.begin() + i * pw);
+        }
+    }
+
+    /* BOX SUMS AND RESPONSE */
+
+    const int tw = x1 - x0;
+    float vMin = FLT_MAX, vMax = -FLT_MAX;
+    for (int i = 0; i < y1 - y0; ++i)
+    {
+        float *resp = responseImg.ptr<float>(y0 + i) + x0;
+        int x = 0;
+#if CV_SIMD
+        const cv::v_float32 vScale = cv::vx_setall_f32(scaleSq), vK = cv::vx_setall_f32(k);
+        cv::v_float32 vecMin = cv::vx_setall_f32(FLT_MAX), vecMax = cv::vx_setall_f32(-FLT_MAX);
+        for (; x <= tw - cv::v_float32::nlanes; x += cv::v_float32::nlanes)
+        {
+            cv::v_float32 sa = cv::vx_setzero_f32(), sb = cv::vx_setzero_f32(), sc = cv::vx_setzero_f32();
+            for (int u = 0; u < blockSize; ++u)
+            {
+                int offset = (i + u) * pw + x;
+                for (int v = 0; v < blockSize; ++v)
+                {
+                    sa += cv::vx_load(&prodA[offset + v]);
+                    sb += cv::vx_load(&prodB[offset + v]);
+                    sc += cv::vx_load(&prodC[offset + v]);
+                }
+            }
+            sa = sa * vScale;
+            sb = sb * vScale;
+            sc = sc * vScale;
+            cv::v_float32 trace = sa + sc;
+            cv::v_float32 r = sa * sc - sb * sb - vK * trace * trace;
+            cv::v_store(resp + x, r);
+            vecMin = cv::v_min(vecMin, r);
+            vecMax = cv::v_max(vecMax, r);
+        }
+        vMin = min(vMin, cv::v_reduce_min(vecMin));
+        vMax = max(vMax, cv::v_reduce_max(vecMax));
+#endif
+        for (; x < tw; ++x)
+        {
+            float sa = 0.0f, sb = 0.0f, sc = 0.0f;
+            for (int u = 0; u < blockSize; ++u)
+            {
+                int offset = (i + u) * pw + x;
+                for (int v = 0; v < blockSize; ++v)
+                {
+                    sa += prodA[offset + v];
+                    sb += prodB[offset + v];
+                    sc += prodC[offset + v];
+                }
+            }
+            sa *= scaleSq;
+            sb *= scaleSq;
+            sc *= scaleSq;
+            float trace = sa + sc;
+            float r = sa * sc - sb * sb - k * trace * trace;
+            resp[x] = r;
+            vMin = min(vMin, r);
+            vMax = max(vMax, r);
+        }
+    }
+    tileMin = vMin;
+    tileMax = vMax;
+}
+
+void HarrisEngine::normalization(float minValue, float maxValue, double &scale, double &shift)
+{
+    // as cv::normalize with NORM_MINMAX to the range 0..255
+    scale = maxValue - minValue > DBL_EPSILON ? 255.0 / ((double)maxValue - minValue) : 0.0;
+    shift = -minValue * scale;
+}
+
+void HarrisEngine::normalized(cv::Mat &dst) const
+{
+    double scale, shift;
+    normalization(minResp, maxResp, scale, shift);
+    responseImg.convertTo(dst, CV_32FC1, scale, shift);
+}
+
+void HarrisEngine::candidates(float minResponse, float kptSize, vector<cv::KeyPoint> &keypoints) const
+{
+    candidates(minResponse, kptSize, minResp, maxResp, keypoints);
+}
+
+void HarrisEngine::candidates(float minResponse, float kptSize, float minValue, float maxValue, vector<cv::KeyPoint> &keypoints) const
+{
+    keypoints.clear();
+    double scale, shift;
+    normalization(minValue, maxValue, scale, shift);
+    if (scale == 0.0)
+    { // constant response, nothing stands out
+        return;
+    }
+    const float scaleF = (float)scale, shiftF = (float)shift;
+
+    int tilesX = tileX.size() - 1;
+    for (size_t ty = 0; ty + 1 < tileY.size(); ++ty)
+    {
+        for (int y = tileY[ty]; y < tileY[ty + 1]; ++y)
+        {
+            const float *resp = responseImg.ptr<float>(y);
+            for (int tx = 0; tx < tilesX; ++tx)
+            {
+                if (tileMax[ty * tilesX + tx] * scaleF + shiftF <= minResponse)
+                { // the normalization is monotonic, so no pixel of this tile is a candidate
+                    continue;
+                }
+                for (int x = tileX[tx]; x < tileX[tx + 1]; ++x)
+                {
+                    float normResponse = resp[x] * scaleF + shiftF;
+                    if (normResponse > minResponse)
+                    {
+                        keypoints.push_back(cv::KeyPoint(cv::Point2f(x, y), kptSize, -1, normResponse));
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef harrisEngine_hpp
+#define harrisEngine_hpp
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+
+// Harris corner response computed tile by tile in a single pass over the image :
+// 3x3 Sobel gradients, structure tensor products, blockSize x blockSize box sums and the response
+// of a tile stay in cache, min/max of the response and the max. of every tile are tracked on the way
+// the response has the scale of cv::cornerHarris(img, dst, blockSize, 3, k, BORDER_DEFAULT)
+class HarrisEngine
+{
+public:
+    explicit HarrisEngine(int blockSize = 2, double k = 0.04); // Sobel aperture is fixed to 3
+
+    // img must be CV_8UC1 and larger than blockSize in both directions, throws invalid_argument otherwise
+    void compute(const cv::Mat &img);
+
+    const cv::Mat &response() const { return responseImg; } // CV_32FC1, valid until the next compute
+    float minValue() const { return minResp; }
+    float maxValue() const { return maxResp; }
+
+    // response scaled to 0..255, same as cv::normalize(response, dst, 0, 255, NORM_MINMAX, CV_32FC1)
+    void normalized(cv::Mat &dst) const;
+
+    // pixels whose normalized response exceeds minResponse, in raster order, as keypoints of size kptSize
+    // with the normalized response, tiles whose max. stays below the threshold are skipped entirely
+    void candidates(float minResponse, float kptSize, std::vector<cv::KeyPoint> &keypoints) const;
+
+    // same, normalized to the response range [minValue, maxValue] of a larger image which this one is a part of
+    void candidates(float minResponse, float kptSize, float minValue, float maxValue, std::vector<cv::KeyPoint> &keypoints) const;
+
+private:
+    static const int TILE_ROWS = 32;
+    static const int TILE_COLS = 256; // products and pixels of a tile take about 100 kB, they fit into L2
+
+    void computeTile(const cv::Mat &img, int x0, int y0, int x1, int y1, float &tileMin, float &tileMax);
+    static void normalization(float minValue, float maxValue, double &scale, double &shift);
+
+    int blockSize;
+    float k;
+    float scaleSq; // squared gradient scale of cv::cornerHarris, 1 / (4 * blockSize * 255)^2
+
+    cv::Mat responseImg;
+    float minResp, maxResp;
+    std::vector<int> tileX, tileY; // tile borders, tile i covers [tileX[i], tileX[i + 1])
+    std::vector<float> tileMax;    // max. response of every tile, row-major
+
+    // scratch buffers of one tile, reused across tiles and calls
+    std::vector<float> pixels;
+    std::vector<float> prodA, prodB, prodC; // dx*dx, dx*dy, dy*dy
+};
+
+#endif /* harrisEngine_hpp */
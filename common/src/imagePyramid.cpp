@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "imagePyramid.hpp"
+
+using namespace std;
+
+// 5-tap binomial filter [1 4 6 4 1] of the row r at its even columns, h[x] = r[2x-2] + 4 r[2x-1] + 6 r[2x] + 4 r[2x+1] + r[2x+2],
+// taps outside the row are reflected (BORDER_REFLECT_101); 16 * 255 fits into 16 bits
+static void binomialRow(const uchar *r, int cols, ushort *h, int dstCols)
+{
+    // columns x0 .. x1 - 1 have all their taps inside the row
+    const int x0 = min(1, dstCols), x1 = max(x0, min(dstCols, (cols - 1) / 2));
+    auto filterReflected = [&](int x) {
+        int t[5];
+        for (int k = 0; k < 5; ++k)
+        {
+            t[k] = r[cv::borderInterpolate(2 * x + k - 2, cols, cv::BORDER_REFLECT_101)];
+        }
+        h[x] = static_cast<ushort>(t[0] + 4 * (t[1] + t[3]) + 6 * t[2] + t[4]);
+    };
+    for (int x = 0; x < x0; ++x)
+    {
+        filterReflected(x);
+    }
+
+    int x = x0;
+#if CV_SIMD
+    const int lanes = cv::v_uint8::nlanes;
+    for (; x + lanes <= x1 && 2 * (x + lanes) + 2 <= cols; x += lanes)
+    { // even and odd columns from 2x - 2 on, widened so the weighted sum of five pixels cannot overflow
+        cv::v_uint8 e0, o0, e1, o1, e2, o2;
+        cv::v_load_deinterleave(r + 2 * x - 2, e0, o0);
+        cv::v_load_deinterleave(r + 2 * x, e1, o1);
+        cv::v_load_deinterleave(r + 2 * x + 2, e2, o2);
+        cv::v_uint16 e0l, e0h, o0l, o0h, e1l, e1h, o1l, o1h, e2l, e2h;
+        cv::v_expand(e0, e0l, e0h);
+        cv::v_expand(o0, o0l, o0h);
+        cv::v_expand(e1, e1l, e1h);
+        cv::v_expand(o1, o1l, o1h);
+        cv::v_expand(e2, e2l, e2h);
+        cv::v_store(h + x, e0l + e2l + ((o0l + o1l) << 2) + (e1l << 2) + (e1l << 1));
+        cv::v_store(h + x + lanes / 2, e0h + e2h + ((o0h + o1h) << 2) + (e1h << 2) + (e1h << 1));
+    }
+#endif
+    for (; x < x1; ++x)
+    {
+        const uchar *c = r + 2 * x;
+        h[x] = static_cast<ushort>(c[-2] + 4 * (c[-1] + c[1]) + 6 * c[0] + c[2]);
+    }
+    for (x = x1; x < dstCols; ++x)
+    {
+        filterReflected(x);
+    }
+}
+
+void downsample2x(const cv::Mat &src, cv::Mat &dst)
+{
+    if (src.type() != CV_8UC1 || dst.type() != CV_8UC1 || dst.cols != (src.cols + 1) / 2 || dst.rows != (src.rows + 1) / 2)
+    {
+        throw invalid_argument("downsample2x : src and dst must be CV_8UC1, dst of half the size of src");
+    }
+
+    // the five source rows of a destination row lie within five consecutive rows, so row y of src is filtered once
+    // into slot y % 5 and reused by the next destination rows
+    static thread_local vector<ushort> rowBuffer;
+    rowBuffer.resize(5 * dst.cols);
+    int slotRow[5] = {-1, -1, -1, -1, -1};
+
+    for (int y = 0; y < dst.rows; ++y)
+    {
+        const ushort *h[5];
+        for (int k = 0; k < 5; ++k)
+        {
+            int sy = cv::borderInterpolate(2 * y + k - 2, src.rows, cv::BORDER_REFLECT_101);
+            ushort *slot = &rowBuffer[(sy % 5) * dst.cols];
+            if (slotRow[sy % 5] != sy)
+            {
+                binomialRow(src.ptr<uchar>(sy), src.cols, slot, dst.cols);
+                slotRow[sy % 5] = sy;
+            }
+            h[k] = slot;
+        }
+
+        // vertical filter, the total weight 256 * 255 still fits into 16 bits, rounded as cv::pyrDown rounds
+        uchar *d = dst.ptr<uchar>(y);
+        int x = 0;
+#if CV_SIMD
+        const int lanes = cv::v_uint8::nlanes, half = lanes / 2;
+        for (; x <= dst.cols - lanes; x += lanes)
+        {
+            cv::v_uint16 c2l = cv::v_load(h[2] + x), c2h = cv::v_load(h[2] + x + half);
+            cv::v_uint16 sl = cv::v_load(h[0] + x) + cv::v_load(h[4] + x) + ((cv::v_load(h[1] + x) + cv::v_load(h[3] + x)) << 2) +
+                              (c2l << 2) + (c2l << 1);
+            cv::v_uint16 sh = cv::v_load(h[0] + x + half) + cv::v_load(h[4] + x + half) +
+                              ((cv::v_load(h[1] + x + half) + cv::v_load(h[3] + x + half)) << 2) + (c2h << 2) + (c2h << 1);
+            cv::v_store(d + x, cv::v_rshr_pack<8>(sl, sh));
+        }
+#endif
+        for (; x < dst.cols; ++x)
+        {
+            d[x] = static_cast<uchar>((h[0][x] + 4 * (h[1][x] + h[3][x]) + 6 * h[2][x] + h[4][x] + 128) >> 8);
+        }
+    }
+}
+
+// reflects the pixels of the level at the center of padded into its border
+static void fillBorder(cv::Mat &padded, int border)
+{
+    const int cols = padded.cols - 2 * border, rows = padded.rows - 2 * border;
+    for (int y = border; y < border + rows; ++y)
+    {
+        uchar *row = padded.ptr<uchar>(y) + border;
+        for (int x = 1; x <= border; ++x)
+        {
+            row[-x] = row[cv::borderInterpolate(-x, cols, cv::BORDER_REFLECT_101)];
+            row[cols - 1 + x] = row[cv::borderInterpolate(cols - 1 + x, cols, cv::BORDER_REFLECT_101)];
+        }
+    }
+    for (int y = 1; y <= border; ++y)
+    {
+        memcpy(padded.ptr(border - y), padded.ptr(border + cv::borderInterpolate(-y, rows, cv::BORDER_REFLECT_101)), padded.cols);
+        memcpy(padded.ptr(border + rows - 1 + y), padded.ptr(border + cv::borderInterpolate(rows - 1 + y, rows, cv::BORDER_REFLECT_101)),
+               padded.cols);
+    }
+}
+
+ImagePyramid::ImagePyramid() : factor(2.0), borderWidth(0)
+{
+}
+
+void ImagePyramid::build(const cv::Mat &img, double scaleFactor, int numLevels, int border)
+{
+    if (img.type() != CV_8UC1 || img.empty() || scaleFactor <= 1.0 || numLevels < 1 || border < 0)
+    {
+        throw invalid_argument("ImagePyramid : needs a CV_8UC1 image, a scale factor above 1 and at least one level");
+    }
+    factor = scaleFactor;
+    borderWidth = border;
+    padded.resize(numLevels);
+    levelViews.resize(numLevels);
+    levelScales.resize(numLevels);
+
+    // the border of level 0 comes from the surrounding image if img is a view into one
+    cv::copyMakeBorder(img, padded[0], border, border, border, border, cv::BORDER_REFLECT_101);
+    levelViews[0] = padded[0](cv::Rect(border, border, img.cols, img.rows));
+    levelScales[0] = 1.0;
+
+    const bool bHalving = scaleFactor == 2.0;
+    for (int i = 1; i < numLevels; ++i)
+    {
+        const cv::Mat &prev = levelViews[i - 1];
+        double scale = pow(scaleFactor, i);
+        cv::Size size = bHalving ? cv::Size((prev.cols + 1) / 2, (prev.rows + 1) / 2)
+                                 : cv::Size(cvRound(img.cols / scale), cvRound(img.rows / scale));
+        if (size.width < 1 || size.height < 1)
+        { // the image is too small for more levels
+            padded.resize(i);
+            levelViews.resize(i);
+            levelScales.resize(i);
+            break;
+        }
+
+        padded[i].create(size.height + 2 * border, size.width + 2 * border, CV_8UC1);
+        levelViews[i] = padded[i](cv::Rect(border, border, size.width, size.height));
+        if (bHalving)
+        {
+            downsample2x(prev, levelViews[i]);
+        }
+        else
+        { // as cv::ORB resizes its levels, the view already has the size, so resize writes into it
+            cv::resize(prev, levelViews[i], size, 0, 0, cv::INTER_LINEAR_EXACT);
+        }
+        fillBorder(padded[i], border);
+        levelScales[i] = scale;
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef imagePyramid_hpp
+#define imagePyramid_hpp
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+
+// pyramid of a CV_8UC1 image with a constant scale factor between neighboring levels, level 0 is the image itself
+// factor 2 levels are Gaussian downsampled from the level below as cv::pyrDown does it (SIMD), so they equal the
+// levels of cv::buildOpticalFlowPyramid; other factors are resized bilinearly from the level below to the size
+// cv::ORB uses, round(size / factor^level)
+// every level lies inside a border of the given width : level 0 takes it from the image around img where img is
+// a view into a larger one, otherwise and on all other levels it is reflected (BORDER_REFLECT_101),
+// so windows may reach up to border pixels outside a level, as cv::calcOpticalFlowPyrLK requires
+class ImagePyramid
+{
+public:
+    ImagePyramid();
+
+    // rebuilds all levels from img, the storage of the previous build is reused if the sizes did not change
+    // throws invalid_argument for images which are not CV_8UC1, factors <= 1 or less than one level
+    void build(const cv::Mat &img, double scaleFactor, int numLevels, int border);
+
+    bool empty() const { return levelViews.empty(); }
+    int levels() const { return static_cast<int>(levelViews.size()); }
+    double scaleFactor() const { return factor; }
+    int border() const { return borderWidth; }
+
+    const cv::Mat &level(int i) const { return levelViews[i]; } // view without the border
+    const std::vector<cv::Mat> &views() const { return levelViews; }
+    double scale(int i) const { return levelScales[i]; } // level 0 pixels per pixel of level i
+
+private:
+    double factor;
+    int borderWidth;
+    std::vector<cv::Mat> padded;     // level with its border
+    std::vector<cv::Mat> levelViews; // level inside padded
+    std::vector<double> levelScales;
+};
+
+// dst = src (CV_8UC1) filtered with the 5x5 binomial kernel [1 4 6 4 1]^T [1 4 6 4 1] / 256 at its even rows and columns,
+// of size ((cols + 1) / 2, (rows + 1) / 2); taps outside src are reflected (BORDER_REFLECT_101) and the sums are rounded,
+// which gives the result of cv::pyrDown bit by bit
+// dst must already have that size, it may be a view into a larger image
+void downsample2x(const cv::Mat &src, cv::Mat &dst);
+
+#endif /* imagePyramid_hpp */
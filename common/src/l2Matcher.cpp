@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <opencv2/core/hal/intrin.hpp>
+
+#include "l2Matcher.hpp"
+
+using namespace std;
+
+#if CV_SIMD
+static const int NR = 2 * cv::v_float32::nlanes; // train descriptors per micro-kernel call
+#else
+static const int NR = 8;
+#endif
+
+// tile[r * NR + c] = q[r] . panel column c, panel holds NR descriptors interleaved dimension by dimension
+static void dotKernel(const float *const *q, const float *panel, int dims, float *tile)
+{
+#if CV_SIMD
+    const int L = cv::v_float32::nlanes;
+    cv::v_float32 c00 = cv::vx_setzero_f32(), c01 = cv::vx_setzero_f32();
+    cv::v_float32 c10 = cv::vx_setzero_f32(), c11 = cv::vx_setzero_f32();
+    cv::v_float32 c20 = cv::vx_setzero_f32(), c21 = cv::vx_setzero_f32();
+    cv::v_float32 c30 = cv::vx_setzero_f32(), c31 = cv::vx_setzero_f32();
+    for (int k = 0; k < dims; ++k, panel += NR)
+    {
+        cv::v_float32 b0 = cv::vx_load(panel), b1 = cv::vx_load(panel + L);
+        cv::v_float32 a = cv::vx_setall_f32(q[0][k]);
+        c00 = cv::v_fma(a, b0, c00);
+        c01 = cv::v_fma(a, b1, c01);
+        a = cv::vx_setall_f32(q[1][k]);
+        c10 = cv::v_fma(a, b0, c10);
+        c11 = cv::v_fma(a, b1, c11);
+        a = cv::vx_setall_f32(q[2][k]);
+        c20 = cv::v_fma(a, b0, c20);
+        c21 = cv::v_fma(a, b1, c21);
+        a = cv::vx_setall_f32(q[3][k]);
+        c30 = cv::v_fma(a, b0, c30);
+        c31 = cv::v_fma(a, b1, c31);
+    }
+    cv::v_store(tile, c00);
+    cv::v_store(tile + L, c01);
+    cv::v_store(tile + NR, c10);
+    cv::v_store(tile + NR + L, c11);
+    cv::v_store(tile + 2 * NR, c20);
+    cv::v_store(tile + 2 * NR + L, c21);
+    cv::v_store(tile + 3 * NR, c30);
+    cv::v_store(tile + 3 * NR + L, c31);
+#else
+    float acc[4][NR] = {};
+    for (int k = 0; k < dims; ++k, panel += NR)
+    {
+        for (int r = 0; r < 4; ++r)
+        {
+            float a = q[r][k];
+            for (int c = 0; c < NR; ++c)
+            {
+                acc[r][c] += a * panel[c];
+            }
+        }
+    }
+    copy(&acc[0][0], &acc[0][0] + 4 * NR, tile);
+#endif
+}
+
+L2Matcher::L2Matcher()
+{
+}
+
+void L2Matcher::pack(const cv::Mat &query, const cv::Mat &train)
+{
+    const int dims = train.cols;
+    const int numPanels = (train.rows + NR - 1) / NR;
+    panels.assign(static_cast<size_t>(numPanels) * NR * dims, 0.0f);
+    trainNorms.assign(static_cast<size_t>(numPanels) * NR, numeric_limits<float>::infinity());
+    for (int j = 0; j < train.rows; ++j)
+    {
+        const float *t = train.ptr<float>(j);
+        float *dst = &panels[static_cast<size_t>(j / NR) * NR * dims + j % NR];
+        float norm = 0.0f;
+        for (int k = 0; k < dims; ++k)
+        {
+            dst[k * NR] = t[k];
+            norm += t[k] * t[k];
+        }
+        trainNorms[j] = norm;
+    }
+
+    queryNorms.resize(query.rows);
+    for (int i = 0; i < query.rows; ++i)
+    {
+        const float *q = query.ptr<float>(i);
+        float norm = 0.0f;
+        for (int k = 0; k < dims; ++k)
+        {
+            norm += q[k] * q[k];
+        }
+        queryNorms[i] = norm;
+    }
+    zeroRow.assign(dims, 0.0f);
+}
+
+void L2Matcher::match(const cv::Mat &query, const cv::Mat &train, double maxRatio, bool bMutual, vector<cv::DMatch> &matches,
+                      ThreadPool *pool)
+{
+    matches.clear();
+    if (query.empty() || train.empty())
+    {
+        return;
+    }
+    if (query.type() != CV_32FC1 || train.type() != CV_32FC1 || query.cols != train.cols)
+    {
+        throw invalid_argument("L2Matcher : descriptors must be CV_32FC1 rows of equal length");
+    }
+    bool bRatio = maxRatio > 0;
+    if (bRatio && train.rows < 2)
+    { // knnMatch would return a single neighbor, which never passes the ratio test
+        return;
+    }
+
+    const int dims = train.cols;
+    const int numPanels = (train.rows + NR - 1) / NR;
+    const float inf = numeric_limits<float>::infinity();
+    pack(query, train);
+    rowBest.assign(query.rows, inf);
+    rowSecond.assign(query.rows, inf);
+    rowBestIdx.assign(query.rows, -1);
+
+    // queries are split into chunks of fixed size, each chunk keeps its own nearest query per train descriptor,
+    // so the result does not depend on how the chunks are spread over threads
+    const int numChunks = (query.rows + QUERY_CHUNK - 1) / QUERY_CHUNK;
+    const size_t numCols = static_cast<size_t>(numPanels) * NR;
+    if (bMutual)
+    {
+        colBest.assign(numChunks * numCols, inf);
+        colBestIdx.assign(numChunks * numCols, -1);
+    }
+
+    // a block of train panels stays in cache while the queries of a chunk pass over it, queries and train descriptors
+    // are both visited in increasing order, so ties resolve to the lower index as in cv::BFMatcher
+    auto matchChunk = [&](int chunk) {
+        const int chunkEnd = min(query.rows, (chunk + 1) * QUERY_CHUNK);
+        float *colDist = bMutual ? &colBest[chunk * numCols] : NULL;
+        int *colIdx = bMutual ? &colBestIdx[chunk * numCols] : NULL;
+        float tile[MR * NR];
+        for (int p0 = 0; p0 < numPanels; p0 += BLOCK_PANELS)
+        {
+            const int p1 = min(numPanels, p0 + BLOCK_PANELS);
+            for (int i0 = chunk * QUERY_CHUNK; i0 < chunkEnd; i0 += MR)
+            {
+                const int rows = min(MR, chunkEnd - i0);
+                const float *q[MR];
+                for (int r = 0; r < MR; ++r)
+                {
+                    q[r] = r < rows ? query.ptr<float>(i0 + r) : zeroRow.data();
+                }
+
+                for (int p = p0; p < p1; ++p)
+                {
+                    dotKernel(q, &panels[static_cast<size_t>(p) * NR * dims], dims, tile);
+
+                    const int j0 = p * NR;
+                    for (int r = 0; r < rows; ++r)
+                    {
+                        const int i = i0 + r;
+                        float best = rowBest[i], second = rowSecond[i];
+                        int bestIdx = rowBestIdx[i];
+                        for (int c = 0; c < NR; ++c)
+                        {
+                            const int j = j0 + c;
+                            float d = queryNorms[i] + trainNorms[j] - 2.0f * tile[r * NR + c];
+                            if (d < best)
+                            {
+                                second = best;
+                                best = d;
+                                bestIdx = j;
+                            }
+                            else if (d < second)
+                            {
+                                second = d;
+                            }
+                            if (colDist && d < colDist[j])
+                            {
+                                colDist[j] = d;
+                                colIdx[j] = i;
+                            }
+                        }
+                        rowBest[i] = best;
+                        rowSecond[i] = second;
+                        rowBestIdx[i] = bestIdx;
+                    }
+                }
+            }
+        }
+    };
+    if (pool)
+    {
+        pool->parallelFor(numChunks, matchChunk);
+    }
+    else
+    {
+        for (int chunk = 0; chunk < numChunks; ++chunk)
+        {
+            matchChunk(chunk);
+        }
+    }
+
+    // chunks are merged in query order, so equally near queries resolve to the first one
+    for (int chunk = 1; bMutual && chunk < numChunks; ++chunk)
+    {
+        const float *dist = &colBest[chunk * numCols];
+        const int *idx = &colBestIdx[chunk * numCols];
+        for (size_t j = 0; j < numCols; ++j)
+        {
+            if (dist[j] < colBest[j])
+            {
+                colBest[j] = dist[j];
+                colBestIdx[j] = idx[j];
+            }
+        }
+    }
+
+    matches.reserve(query.rows);
+    for (int i = 0; i < query.rows; ++i)
+    {
+        float best = sqrt(max(rowBest[i], 0.0f));
+        if (bRatio && !(best < maxRatio * sqrt(max(rowSecond[i], 0.0f))))
+        {
+            continue;
+        }
+        if (bMutual && colBestIdx[rowBestIdx[i]] != i)
+        {
+            continue;
+        }
+        matches.push_back(cv::DMatch(i, rowBestIdx[i], best));
+    }
+}
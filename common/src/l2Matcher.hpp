@@ -0,0 +1,46 @@
+#ifndef l2Matcher_hpp
+#define l2Matcher_hpp
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "threadPool.hpp"
+
+
+// brute-force matching of float descriptors (SIFT) under the L2 norm, formulated as a matrix product :
+// |q - t|^2 = |q|^2 + |t|^2 - 2 q.t, the dot products are computed by a register-blocked micro-kernel
+// (4 queries x 2 SIMD vectors of train descriptors) over cache-sized blocks of packed train descriptors
+// the distance matrix is never stored, every tile only updates the best and second best train descriptor
+// of its queries and the best query of its train descriptors
+class L2Matcher
+{
+public:
+    L2Matcher();
+
+    // query and train are CV_32FC1 with one descriptor per row and the same no. of columns, throws invalid_argument otherwise
+    // maxRatio <= 0 : nearest neighbor of every query, as cv::BFMatcher(NORM_L2).match
+    // maxRatio > 0  : nearest neighbor of the queries which pass best < maxRatio * second best, as knnMatch with k = 2
+    //                 followed by the ratio test, a query with a single train candidate is dropped
+    // bMutual       : additionally drop a match unless the query is also the nearest neighbor of its train descriptor
+    // distances are rounded differently than by cv::BFMatcher, so near ties may resolve to the other candidate
+    // with a pool, chunks of queries are matched in parallel, the result is the same for any no. of threads
+    void match(const cv::Mat &query, const cv::Mat &train, double maxRatio, bool bMutual, std::vector<cv::DMatch> &matches,
+               ThreadPool *pool = NULL);
+
+private:
+    static const int MR = 4;            // queries per micro-kernel call
+    static const int BLOCK_PANELS = 16; // train panels per cache block, 64 kB of SIFT descriptors with 4-lane SIMD
+    static const int QUERY_CHUNK = 64;  // queries per parallel task, a multiple of MR
+
+    void pack(const cv::Mat &query, const cv::Mat &train);
+
+    std::vector<float> panels;                   // train descriptors in groups of NR, dimension-major within a group
+    std::vector<float> queryNorms, trainNorms;   // squared norms, padded train columns are infinitely far away
+    std::vector<float> rowBest, rowSecond;       // squared distances of the two nearest train descriptors of every query
+    std::vector<int> rowBestIdx;
+    std::vector<float> colBest;                  // nearest query of every train descriptor, one set per chunk of queries
+    std::vector<int> colBestIdx;
+    std::vector<float> zeroRow;                  // stands in for the missing queries of the last group
+};
+
+#endif /* l2Matcher_hpp */
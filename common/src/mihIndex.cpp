@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <opencv2/core/hal/hal.hpp>
+
+#include "mihIndex.hpp"
+
+using namespace std;
+
+static const int MAX_SUBSTRING_BITS = 16; // keeps every table a directly addressed array of 2^16 buckets at most
+static const int QUERY_CHUNK = 64;        // queries per parallel task
+
+// numBits <= 16 bits of d starting at bit bitOffset, bit 0 is the lowest bit of the first byte
+static inline uint32_t extractBits(const uchar *d, int rowBytes, int bitOffset, int numBits)
+{
+    int byte = bitOffset >> 3;
+    uint32_t v = 0;
+    for (int b = 0; b < 3 && byte + b < rowBytes; ++b)
+    {
+        v |= static_cast<uint32_t>(d[byte + b]) << (8 * b);
+    }
+    return (v >> (bitOffset & 7)) & ((1u << numBits) - 1);
+}
+
+// next larger integer with the same no. of set bits
+static inline uint32_t nextCombination(uint32_t mask)
+{
+    uint32_t lowest = mask & (~mask + 1);
+    uint32_t ripple = mask + lowest;
+    return (((ripple ^ mask) >> 2) / lowest) | ripple;
+}
+
+MihIndex::MihIndex() : numItems(0), rowBytes(0)
+{
+}
+
+void MihIndex::build(const cv::Mat &descriptors, int numSubstrings)
+{
+    if (!descriptors.empty() && descriptors.type() != CV_8UC1)
+    {
+        throw invalid_argument("MihIndex : descriptors must be CV_8UC1");
+    }
+    data = descriptors.clone();
+    numItems = data.rows;
+    rowBytes = data.cols;
+    tables.clear();
+    if (numItems == 0)
+    {
+        return;
+    }
+
+    // substrings of about log2(n) bits leave roughly one descriptor per bucket
+    const int bits = 8 * rowBytes;
+    int m = numSubstrings;
+    if (m <= 0)
+    {
+        m = static_cast<int>(lround(bits / log2(max(numItems, 2))));
+    }
+    m = min(bits, max(m, (bits + MAX_SUBSTRING_BITS - 1) / MAX_SUBSTRING_BITS));
+
+    tables.resize(m);
+    int bitOffset = 0;
+    for (int j = 0; j < m; ++j)
+    {
+        Table &t = tables[j];
+        t.bitOffset = bitOffset;
+        t.numBits = bits / m + (j < bits % m ? 1 : 0);
+        bitOffset += t.numBits;
+
+        // counting sort of the items by substring, stable so buckets list their items in ascending order
+        vector<uint32_t> keys(numItems);
+        t.offsets.assign((1u << t.numBits) + 1, 0);
+        for (int i = 0; i < numItems; ++i)
+        {
+            keys[i] = extractBits(data.ptr<uchar>(i), rowBytes, t.bitOffset, t.numBits);
+            ++t.offsets[keys[i] + 1];
+        }
+        for (size_t b = 1; b < t.offsets.size(); ++b)
+        {
+            t.offsets[b] += t.offsets[b - 1];
+        }
+        t.items.resize(numItems);
+        vector<int> fill(t.offsets.begin(), t.offsets.end() - 1);
+        for (int i = 0; i < numItems; ++i)
+        {
+            t.items[fill[keys[i]]++] = i;
+        }
+    }
+}
+
+static const char MIH_MAGIC[8] = {'M', 'I', 'H', 'I', 'N', 'D', 'X', '1'};
+
+template <typename T>
+static void writeArray(ostream &out, const T *values, size_t count)
+{
+    out.write(reinterpret_cast<const char *>(values), count * sizeof(T));
+}
+
+template <typename T>
+static void readArray(istream &in, T *values, size_t count)
+{
+    in.read(reinterpret_cast<char *>(values), count * sizeof(T));
+}
+
+void MihIndex::write(ostream &out) const
+{
+    int32_t header[3] = {numItems, rowBytes, static_cast<int32_t>(tables.size())};
+    out.write(MIH_MAGIC, sizeof(MIH_MAGIC));
+    writeArray(out, header, 3);
+    for (const Table &t : tables)
+    {
+        int32_t layout[2] = {t.bitOffset, t.numBits};
+        writeArray(out, layout, 2);
+        writeArray(out, t.offsets.data(), t.offsets.size());
+        writeArray(out, t.items.data(), t.items.size());
+    }
+}
+
+void MihIndex::read(istream &in, const cv::Mat &descriptors)
+{
+    char magic[sizeof(MIH_MAGIC)];
+    int32_t header[3];
+    in.read(magic, sizeof(magic));
+    readArray(in, header, 3);
+    if (!in || !equal(magic, magic + sizeof(magic), MIH_MAGIC) || header[0] != descriptors.rows || header[1] != descriptors.cols ||
+        header[2] < 0 || header[2] > 8 * header[1] || (!descriptors.empty() && descriptors.type() != CV_8UC1))
+    {
+        throw runtime_error("MihIndex : stream does not hold an index of these descriptors");
+    }
+
+    data = descriptors.clone();
+    numItems = header[0];
+    rowBytes = header[1];
+    tables.resize(header[2]);
+    for (Table &t : tables)
+    {
+        int32_t layout[2];
+        readArray(in, layout, 2);
+        if (!in || layout[1] < 1 || layout[1] > MAX_SUBSTRING_BITS || layout[0] < 0 || layout[0] + layout[1] > 8 * rowBytes)
+        {
+            throw runtime_error("MihIndex : corrupt table layout");
+        }
+        t.bitOffset = layout[0];
+        t.numBits = layout[1];
+        t.offsets.resize((1u << t.numBits) + 1);
+        t.items.resize(numItems);
+        readArray(in, t.offsets.data(), t.offsets.size());
+        readArray(in, t.items.data(), t.items.size());
+        bool bValid = in && t.offsets.front() == 0 && t.offsets.back() == numItems &&
+                      is_sorted(t.offsets.begin(), t.offsets.end()) &&
+                      all_of(t.items.begin(), t.items.end(), [this](int idx) { return idx >= 0 && idx < numItems; });
+        if (!bValid)
+        {
+            throw runtime_error("MihIndex : truncated or corrupt table");
+        }
+    }
+}
+
+size_t MihIndex::search(const uchar *query, int k, double maxRatio, vector<cv::DMatch> &result, vector<unsigned> &stamp,
+                        unsigned &stampValue) const
+{
+    result.clear();
+    k = min(k, numItems);
+    if (k <= 0)
+    {
+        return 0;
+    }
+    if (++stampValue == 0)
+    {
+        fill(stamp.begin(), stamp.end(), 0);
+        stampValue = 1;
+    }
+
+    size_t compared = 0;
+    auto probe = [&](const Table &t, uint32_t bucket) {
+        for (int b = t.offsets[bucket]; b < t.offsets[bucket + 1]; ++b)
+        {
+            int idx = t.items[b];
+            if (stamp[idx] == stampValue)
+            {
+                continue;
+            }
+            stamp[idx] = stampValue;
+            ++compared;
+
+            // sorted insert into the k best, ordered by distance and index
+            float d = static_cast<float>(cv::hal::normHamming(query, data.ptr<uchar>(idx), rowBytes));
+            if (static_cast<int>(result.size()) == k)
+            {
+                const cv::DMatch &last = result.back();
+                if (d > last.distance || (d == last.distance && idx > last.trainIdx))
+                {
+                    continue;
+                }
+                result.pop_back();
+            }
+            auto pos = result.end();
+            while (pos != result.begin() && ((pos - 1)->distance > d || ((pos - 1)->distance == d && (pos - 1)->trainIdx > idx)))
+            {
+                --pos;
+            }
+            result.insert(pos, cv::DMatch(0, idx, d));
+        }
+    };
+
+    // after probing tables 0..j with radius r (and all tables with r - 1), a descriptor which has not been seen
+    // differs in at least r + 1 bits in j + 1 substrings and in at least r bits in the others,
+    // so every descriptor within m * r + j bits of the query has been compared
+    const int m = static_cast<int>(tables.size());
+    for (int r = 0; ; ++r)
+    {
+        for (int j = 0; j < m; ++j)
+        {
+            const Table &t = tables[j];
+            if (r <= t.numBits)
+            {
+                uint32_t key = extractBits(query, rowBytes, t.bitOffset, t.numBits);
+                if (r == 0)
+                {
+                    probe(t, key);
+                }
+                for (uint32_t mask = (1u << r) - 1; r > 0 && mask < (1u << t.numBits); mask = nextCombination(mask))
+                {
+                    probe(t, key ^ mask);
+                }
+            }
+            const float bound = static_cast<float>(m * r + j);
+            if (compared == static_cast<size_t>(numItems) || (static_cast<int>(result.size()) == k && result.back().distance <= bound))
+            {
+                if (maxRatio > 0 && !(result.size() == 2 && result[0].distance < maxRatio * result[1].distance))
+                {
+                    result.clear();
+                }
+                result.resize(min<size_t>(result.size(), maxRatio > 0 ? 1 : k));
+                return compared;
+            }
+            if (maxRatio > 0 && !result.empty() && result[0].distance <= bound)
+            { // the nearest neighbor is final, the ratio test is decided by a close enough second one
+              // or once every descriptor which could still fail it has been seen
+                if (result.size() == 2 && result[0].distance >= maxRatio * result[1].distance)
+                {
+                    result.clear();
+                    return compared;
+                }
+                if (result[0].distance < maxRatio * (bound + 1))
+                {
+                    result.resize(1);
+                    return compared;
+                }
+            }
+        }
+    }
+}
+
+size_t MihIndex::knnMatch(const cv::Mat &queries, int k, vector<vector<cv::DMatch> > &matches, ThreadPool *pool) const
+{
+    matches.assign(queries.rows, vector<cv::DMatch>());
+    if (queries.empty() || numItems == 0)
+    {
+        return 0;
+    }
+    if (queries.type() != CV_8UC1 || queries.cols != rowBytes)
+    {
+        throw invalid_argument("MihIndex : queries must be CV_8UC1 rows of the indexed length");
+    }
+
+    return searchAll(queries, k, 0.0, matches, pool);
+}
+
+size_t MihIndex::searchAll(const cv::Mat &queries, int k, double maxRatio, vector<vector<cv::DMatch> > &matches, ThreadPool *pool) const
+{
+    const int numChunks = (queries.rows + QUERY_CHUNK - 1) / QUERY_CHUNK;
+    vector<size_t> compared(numChunks, 0);
+    auto searchChunk = [&](int c) {
+        vector<unsigned> stamp(numItems, 0);
+        unsigned stampValue = 0;
+        for (int i = c * QUERY_CHUNK; i < min(queries.rows, (c + 1) * QUERY_CHUNK); ++i)
+        {
+            compared[c] += search(queries.ptr<uchar>(i), k, maxRatio, matches[i], stamp, stampValue);
+            for (auto &match : matches[i])
+            {
+                match.queryIdx = i;
+            }
+        }
+    };
+    if (pool)
+    {
+        pool->parallelFor(numChunks, searchChunk);
+    }
+    else
+    {
+        for (int c = 0; c < numChunks; ++c)
+        {
+            searchChunk(c);
+        }
+    }
+
+    size_t total = 0;
+    for (size_t n : compared)
+    {
+        total += n;
+    }
+    return total;
+}
+
+size_t MihIndex::match(const cv::Mat &queries, double maxRatio, vector<cv::DMatch> &matches, ThreadPool *pool) const
+{
+    matches.clear();
+    bool bRatio = maxRatio > 0;
+    if (queries.empty() || numItems == 0 || (bRatio && numItems < 2))
+    { // knnMatch would return a single neighbor, which never passes the ratio test
+        return 0;
+    }
+    if (queries.type() != CV_8UC1 || queries.cols != rowBytes)
+    {
+        throw invalid_argument("MihIndex : queries must be CV_8UC1 rows of the indexed length");
+    }
+
+    vector<vector<cv::DMatch> > nearest(queries.rows);
+    size_t compared = searchAll(queries, bRatio ? 2 : 1, maxRatio, nearest, pool);
+    for (const auto &best : nearest)
+    {
+        if (!best.empty())
+        {
+            matches.push_back(best[0]);
+        }
+    }
+    return compared;
+}
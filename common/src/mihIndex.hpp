@@ -0,0 +1,64 @@
+#ifndef mihIndex_hpp
+#define mihIndex_hpp
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "threadPool.hpp"
+
+
+// multi-index hashing of binary descriptors for exact k nearest neighbor search under the Hamming distance :
+// the descriptor bits are split into m substrings and every substring is indexed in its own hash table,
+// two descriptors within distance R agree up to floor(R / m) bits in at least one substring, so a search
+// enumerates the buckets around the query substrings with growing radius and stops once the k-th best
+// distance found cannot be beaten by a descriptor which has not been seen yet
+// the index is read-only after build, any no. of threads may search it at the same time
+class MihIndex
+{
+public:
+    MihIndex();
+
+    // descriptors are CV_8UC1 with one descriptor per row, they are copied into the index
+    // numSubstrings = 0 picks m ~ bits / log2(rows), substrings are at most 16 bits long
+    void build(const cv::Mat &descriptors, int numSubstrings = 0);
+
+    // the tables in binary form, read() takes the descriptors the index was built on and throws runtime_error
+    // if the stream does not hold an index of that many descriptors of that length
+    void write(std::ostream &out) const;
+    void read(std::istream &in, const cv::Mat &descriptors);
+
+    bool empty() const { return numItems == 0; }
+    int size() const { return numItems; }
+    int substrings() const { return static_cast<int>(tables.size()); }
+
+    // k nearest neighbors of every query row sorted by distance, equal distances by index, as cv::BFMatcher::knnMatch
+    // returns the no. of distinct indexed descriptors whose full distance was computed, summed over all queries
+    size_t knnMatch(const cv::Mat &queries, int k, std::vector<std::vector<cv::DMatch> > &matches, ThreadPool *pool = NULL) const;
+
+    // nearest neighbor per query, with maxRatio > 0 only for queries which pass best < maxRatio * second best,
+    // same semantics as HammingMatcher::match without cross-check
+    size_t match(const cv::Mat &queries, double maxRatio, std::vector<cv::DMatch> &matches, ThreadPool *pool = NULL) const;
+
+private:
+    struct Table {
+        int bitOffset, numBits;
+        std::vector<int> offsets; // bucket b holds items[offsets[b] .. offsets[b + 1]), 2^numBits + 1 entries
+        std::vector<int> items;   // item indices, ascending within a bucket
+    };
+
+    // k nearest neighbors of one query, stamp / stampValue mark the items already compared
+    // with maxRatio > 0 (and k = 2) only the nearest neighbor is kept, if it passes the ratio test, which is often
+    // decided long before the second nearest neighbor is known
+    size_t search(const uchar *query, int k, double maxRatio, std::vector<cv::DMatch> &result, std::vector<unsigned> &stamp,
+                  unsigned &stampValue) const;
+    size_t searchAll(const cv::Mat &queries, int k, double maxRatio, std::vector<std::vector<cv::DMatch> > &matches,
+                     ThreadPool *pool) const;
+
+    int numItems, rowBytes;
+    cv::Mat data; // copy of the indexed descriptors
+    std::vector<Table> tables;
+};
+
+#endif /* mihIndex_hpp */
@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <opencv2/imgproc.hpp>
+
+#include "nms.hpp"
+
+using namespace std;
+
+static void checkResponse(const cv::Mat &response)
+{
+    if (response.type() != CV_32FC1)
+    {
+        throw invalid_argument("non-maximum suppression expects a CV_32FC1 response image");
+    }
+}
+
+void nonMaximumSuppression(const cv::Mat &response, float minResponse, float kptSize, double maxOverlap, NmsMode mode,
+                           vector<cv::KeyPoint> &keypoints)
+{
+    switch (mode)
+    {
+    case NmsMode::NMS_MAX_FILTER:
+        nmsMaxFilter(response, minResponse, kptSize, keypoints);
+        break;
+    case NmsMode::NMS_GRID:
+        nmsOverlapGrid(response, minResponse, kptSize, maxOverlap, keypoints);
+        break;
+    case NmsMode::NMS_OVERLAP_LOOP:
+        nmsOverlapLoop(response, minResponse, kptSize, maxOverlap, keypoints);
+        break;
+    default:
+        throw invalid_argument("invalid NMS mode");
+    }
+}
+
+void nmsOverlapLoop(const cv::Mat &response, float minResponse, float kptSize, double maxOverlap, vector<cv::KeyPoint> &keypoints)
+{
+    checkResponse(response);
+    keypoints.clear();
+    for (int j = 0; j < response.rows; ++j)
+    {
+        const float *row = response.ptr<float>(j);
+        for (int i = 0; i < response.cols; ++i)
+        {
+            if (!(row[i] > minResponse))
+            {
+                continue;
+            }
+            cv::KeyPoint newKeyPoint(cv::Point2f(i, j), kptSize, -1, row[i]);
+
+            // perform non-maximum suppression (NMS) in local neighbourhood around new key point
+            bool bOverlap = false;
+            for (auto it = keypoints.begin(); it != keypoints.end(); ++it)
+            {
+                if (cv::KeyPoint::overlap(newKeyPoint, *it) > maxOverlap)
+                {
+                    bOverlap = true;
+                    if (newKeyPoint.response > it->response)
+                    {                      // if overlap is >t AND response is higher for new kpt
+                        *it = newKeyPoint; // replace old key point with new one
+                        break;             // quit loop over keypoints
+                    }
+                }
+            }
+            if (!bOverlap)
+            {
+                keypoints.push_back(newKeyPoint);
+            }
+        }
+    }
+}
+
+void nmsOverlapGrid(const cv::Mat &response, float minResponse, float kptSize, double maxOverlap, vector<cv::KeyPoint> &keypoints)
+{
+    checkResponse(response);
+    if (maxOverlap < 0.0)
+    {
+        nmsOverlapLoop(response, minResponse, kptSize, maxOverlap, keypoints);
+        return;
+    }
+    vector<cv::KeyPoint> candidates;
+    for (int j = 0; j < response.rows; ++j)
+    {
+        const float *row = response.ptr<float>(j);
+        for (int i = 0; i < response.cols; ++i)
+        {
+            if (row[i] > minResponse)
+            {
+                candidates.push_back(cv::KeyPoint(cv::Point2f(i, j), kptSize, -1, row[i]));
+            }
+        }
+    }
+    nmsOverlapGrid(candidates, maxOverlap, keypoints);
+}
+
+void nmsOverlapGrid(const vector<cv::KeyPoint> &candidates, double maxOverlap, vector<cv::KeyPoint> &keypoints)
+{
+    if (maxOverlap < 0.0)
+    { // every pair of keypoints overlaps, there is no neighbourhood to restrict the search to
+        throw invalid_argument("grid NMS needs a non-negative max. overlap");
+    }
+    keypoints.clear();
+    if (candidates.empty())
+    {
+        return;
+    }
+
+    // keypoints of equal size only overlap if their centers are closer than their size,
+    // with cells of that size they lie in the same or in adjacent cells
+    float kptSize = candidates[0].size;
+    int cellSize = max(1, (int)ceil(kptSize));
+    int maxX = 0, maxY = 0;
+    for (const auto &candidate : candidates)
+    {
+        maxX = max(maxX, (int)candidate.pt.x);
+        maxY = max(maxY, (int)candidate.pt.y);
+    }
+    int gridCols = maxX / cellSize + 1;
+    int gridRows = maxY / cellSize + 1;
+    vector<vector<int>> cells(gridCols * gridRows); // indices into keypoints
+    auto cellOf = [&](const cv::Point2f &pt) { return ((int)pt.y / cellSize) * gridCols + (int)pt.x / cellSize; };
+
+    for (const auto &newKeyPoint : candidates)
+    {
+        // the loop version replaces the first overlapping keypoint with a lower response in list order,
+        // so the lowest such index among all neighbours is the one to replace
+        bool bOverlap = false;
+        int replaceIdx = -1;
+        int cx = (int)newKeyPoint.pt.x / cellSize, cy = (int)newKeyPoint.pt.y / cellSize;
+        for (int y = max(0, cy - 1); y <= min(gridRows - 1, cy + 1); ++y)
+        {
+            for (int x = max(0, cx - 1); x <= min(gridCols - 1, cx + 1); ++x)
+            {
+                for (int idx : cells[y * gridCols + x])
+                {
+                    if (cv::KeyPoint::overlap(newKeyPoint, keypoints[idx]) > maxOverlap)
+                    {
+                        bOverlap = true;
+                        if (newKeyPoint.response > keypoints[idx].response && (replaceIdx < 0 || idx < replaceIdx))
+                        {
+                            replaceIdx = idx;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (replaceIdx >= 0)
+        { // move the replaced keypoint into the cell of the new one
+            vector<int> &oldCell = cells[cellOf(keypoints[replaceIdx].pt)];
+            *find(oldCell.begin(), oldCell.end(), replaceIdx) = oldCell.back();
+            oldCell.pop_back();
+            keypoints[replaceIdx] = newKeyPoint;
+            cells[cy * gridCols + cx].push_back(replaceIdx);
+        }
+        else if (!bOverlap)
+        {
+            cells[cy * gridCols + cx].push_back(keypoints.size());
+            keypoints.push_back(newKeyPoint);
+        }
+    }
+}
+
+void nmsMaxFilter(const cv::Mat &response, float minResponse, float kptSize, vector<cv::KeyPoint> &keypoints)
+{
+    checkResponse(response);
+    keypoints.clear();
+
+    // max. response within the odd-sized window which covers the keypoint diameter
+    int windowSize = 2 * (int)(kptSize / 2) + 1;
+    cv::Mat localMax;
+    cv::dilate(response, localMax, cv::getStructuringElement(cv::MORPH_RECT, cv::Size(windowSize, windowSize)));
+
+    for (int j = 0; j < response.rows; ++j)
+    {
+        const float *row = response.ptr<float>(j);
+        const float *maxRow = localMax.ptr<float>(j);
+        for (int i = 0; i < response.cols; ++i)
+        {
+            if (row[i] > minResponse && row[i] == maxRow[i])
+            {
+                keypoints.push_back(cv::KeyPoint(cv::Point2f(i, j), kptSize, -1, row[i]));
+            }
+        }
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef nms_hpp
+#define nms_hpp
+
+#include <vector>
+#include <opencv2/core.hpp>
+
+
+// non-maximum suppression of a corner response image (CV_32FC1), shared by the Harris detectors
+// every pixel with a response above minResponse is a candidate keypoint of diameter kptSize
+enum class NmsMode {
+    NMS_MAX_FILTER, // keep candidates which are the maximum of the kptSize x kptSize window around them (dilate)
+    NMS_GRID,       // same result as NMS_OVERLAP_LOOP, candidates are looked up in a spatial hash grid
+    NMS_OVERLAP_LOOP // reference : compare each candidate with every keypoint kept so far, O(n^2)
+};
+
+void nonMaximumSuppression(const cv::Mat &response, float minResponse, float kptSize, double maxOverlap, NmsMode mode,
+                           std::vector<cv::KeyPoint> &keypoints);
+
+// raster scan over the candidates, a candidate which overlaps (cv::KeyPoint::overlap > maxOverlap) a kept keypoint
+// replaces the first overlapping one with a lower response, or is dropped if there is none
+void nmsOverlapLoop(const cv::Mat &response, float minResponse, float kptSize, double maxOverlap, std::vector<cv::KeyPoint> &keypoints);
+void nmsOverlapGrid(const cv::Mat &response, float minResponse, float kptSize, double maxOverlap, std::vector<cv::KeyPoint> &keypoints);
+
+// grid NMS of candidates which are already thresholded, e.g. by HarrisEngine::candidates
+// candidates must be in raster order, at integer pixel positions and of equal size
+void nmsOverlapGrid(const std::vector<cv::KeyPoint> &candidates, double maxOverlap, std::vector<cv::KeyPoint> &keypoints);
+
+// plateaus of equal maximum response keep all of their pixels
+void nmsMaxFilter(const cv::Mat &response, float minResponse, float kptSize, std::vector<cv::KeyPoint> &keypoints);
+
+#endif /* nms_hpp */
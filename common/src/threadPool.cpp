@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <exception>
+
+#include "threadPool.hpp"
+
+using namespace std;
+
+struct ThreadPool::Job {
+    const function<void(int)> *body;
+    atomic<int> remaining;
+    mutex doneMutex;
+    condition_variable done;
+    exception_ptr error; // first exception, guarded by doneMutex
+
+    Job(const function<void(int)> &f, int n) : body(&f), remaining(n) {}
+};
+
+// worker index of the current thread within the pool it belongs to
+static thread_local const ThreadPool *currentPool = NULL;
+static thread_local int currentWorker = -1;
+
+ThreadPool::ThreadPool(int numThreads) : pending(0), nextVictim(0), bStop(false)
+{
+    if (numThreads <= 0)
+    {
+        numThreads = max(1u, thread::hardware_concurrency());
+    }
+    for (int i = 1; i < numThreads; ++i)
+    {
+        queues.push_back(unique_ptr<WorkQueue>(new WorkQueue()));
+    }
+    for (int i = 0; i + 1 < numThreads; ++i)
+    {
+        workers.push_back(thread(&ThreadPool::workerLoop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(sleepMutex);
+        bStop = true;
+    }
+    wakeUp.notify_all();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+ThreadPool &ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+bool ThreadPool::popTask(int self, Task &task)
+{
+    if (pending.load() == 0)
+    {
+        return false;
+    }
+    const int numQueues = static_cast<int>(queues.size());
+    if (self >= 0)
+    { // newest task of the own deque, its data is most likely still in cache
+        WorkQueue &own = *queues[self];
+        lock_guard<mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            --pending;
+            return true;
+        }
+    }
+
+    int first = self >= 0 ? self + 1 : static_cast<int>(nextVictim++ % numQueues);
+    for (int k = 0; k < numQueues; ++k)
+    { // oldest task of another deque
+        WorkQueue &victim = *queues[(first + k) % numQueues];
+        lock_guard<mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            --pending;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::execute(const Task &task)
+{
+    Job &job = *task.job;
+    exception_ptr error;
+    try
+    {
+        (*job.body)(task.index);
+    }
+    catch (...)
+    {
+        error = current_exception();
+    }
+
+    // the waiting thread may destroy the job as soon as it can take doneMutex after the last task
+    lock_guard<mutex> lock(job.doneMutex);
+    if (error && !job.error)
+    {
+        job.error = error;
+    }
+    if (--job.remaining == 0)
+    {
+        job.done.notify_all();
+    }
+}
+
+void ThreadPool::workerLoop(int self)
+{
+    currentPool = this;
+    currentWorker = self;
+    while (true)
+    {
+        Task task;
+        if (popTask(self, task))
+        {
+            execute(task);
+            continue;
+        }
+        unique_lock<mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return bStop || pending.load() > 0; });
+        if (bStop && pending.load() == 0)
+        {
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallelFor(int n, const function<void(int)> &body)
+{
+    if (n <= 0)
+    {
+        return;
+    }
+    if (queues.empty() || n == 1)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            body(i);
+        }
+        return;
+    }
+
+    // contiguous ranges of tasks per deque, stealing evens out the rest
+    Job job(body, n);
+    const int numQueues = static_cast<int>(queues.size());
+    for (int q = 0; q < numQueues; ++q)
+    {
+        WorkQueue &queue = *queues[q];
+        lock_guard<mutex> lock(queue.mutex);
+        for (int i = q * n / numQueues; i < (q + 1) * n / numQueues; ++i)
+        {
+            queue.tasks.push_back(Task{&job, i});
+        }
+    }
+    pending += n;
+    {
+        lock_guard<mutex> lock(sleepMutex);
+    }
+    wakeUp.notify_all();
+
+    // help out until the last task of this job finished, tasks of other jobs may be run on the way
+    int self = currentPool == this ? currentWorker : -1;
+    while (job.remaining.load() > 0)
+    {
+        Task task;
+        if (popTask(self, task))
+        {
+            execute(task);
+            continue;
+        }
+        unique_lock<mutex> lock(job.doneMutex);
+        job.done.wait(lock, [&job]() { return job.remaining.load() == 0; });
+    }
+
+    lock_guard<mutex> lock(job.doneMutex);
+    if (job.error)
+    {
+        rethrow_exception(job.error);
+    }
+}
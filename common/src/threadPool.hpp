@@ -0,0 +1,55 @@
+#ifndef threadPool_hpp
+#define threadPool_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// fork-join thread pool with one task deque per worker : a worker takes tasks from the back of its own deque
+// and steals from the front of the others once it runs dry, so unevenly sized tasks balance out
+// the thread calling parallelFor runs tasks as well while it waits, which also makes nested calls safe
+class ThreadPool
+{
+public:
+    explicit ThreadPool(int numThreads = 0); // incl. the calling thread, 0 = one per hardware thread
+    ~ThreadPool();
+
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+
+    // runs body(0) ... body(n - 1) and blocks until all of them returned, in no particular order and on any thread
+    // the first exception thrown by body is rethrown here after the remaining tasks finished
+    void parallelFor(int n, const std::function<void(int)> &body);
+
+    static ThreadPool &shared(); // process-wide pool with one thread per hardware thread
+
+private:
+    struct Job;
+    struct Task {
+        Job *job;
+        int index;
+    };
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(int self);
+    bool popTask(int self, Task &task); // own deque first, then steal, self < 0 for threads outside the pool
+    void execute(const Task &task);
+
+    std::vector<std::unique_ptr<WorkQueue> > queues; // one per worker
+    std::vector<std::thread> workers;
+    std::atomic<int> pending; // tasks in all queues
+    std::atomic<unsigned> nextVictim; // spreads the steals of outside threads over the queues
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    bool bStop;
+};
+
+#endif /* threadPool_hpp */
@@ -5,6 +5,9 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/features2d.hpp>
 
+#include "nms.hpp"
+#include "harrisEngine.hpp"
+
 using namespace std;
 
 void cornernessHarris()
@@ -16,15 +19,15 @@ void cornernessHarris()
 
     // Detector parameters
     int blockSize = 2;     // for every pixel, a blockSize × blockSize neighborhood is considered
-    int apertureSize = 3;  // aperture parameter for Sobel operator (must be odd)
+    int apertureSize = 3;  // aperture parameter for Sobel operator, HarrisEngine always uses 3
     int minResponse = 100; // minimum value for a corner in the 8bit scaled response matrix
     double k = 0.04;       // Harris parameter (see equation for details)
 
-    // Detect Harris corners and normalize output
-    cv::Mat dst, dst_norm, dst_norm_scaled;
-    dst = cv::Mat::zeros(img.size(), CV_32FC1);
-    cv::cornerHarris(img, dst, blockSize, apertureSize, k, cv::BORDER_DEFAULT);
-    cv::normalize(dst, dst_norm, 0, 255, cv::NORM_MINMAX, CV_32FC1, cv::Mat());
+    // Detect Harris corners in a single pass and normalize output
+    HarrisEngine harris(blockSize, k);
+    harris.compute(img);
+    cv::Mat dst_norm, dst_norm_scaled;
+    harris.normalized(dst_norm);
     cv::convertScaleAbs(dst_norm, dst_norm_scaled);
 
     // visualize results
@@ -36,41 +39,12 @@ void cornernessHarris()
     // Look for prominent corners and instantiate keypoints
     vector<cv::KeyPoint> keypoints;
     double maxOverlap = 0.0; // max. permissible overlap between two features in %, used during non-maxima suppression
-    for (size_t j = 0; j < dst_norm.rows; j++)
-    {
-        for (size_t i = 0; i < dst_norm.cols; i++)
-        {
-            int response = (int)dst_norm.at<float>(j, i);
-            if (response > minResponse)
-            { // only store points above a threshold
-
-                cv::KeyPoint newKeyPoint;
-                newKeyPoint.pt = cv::Point2f(i, j);
-                newKeyPoint.size = 2 * apertureSize;
-                newKeyPoint.response = response;
 
-                // perform non-maximum suppression (NMS) in local neighbourhood around new key point
-                bool bOverlap = false;
-                for (auto it = keypoints.begin(); it != keypoints.end(); ++it)
-                {
-                    double kptOverlap = cv::KeyPoint::overlap(newKeyPoint, *it);
-                    if (kptOverlap > maxOverlap)
-                    {
-                        bOverlap = true;
-                        if (newKeyPoint.response > (*it).response)
-                        {                      // if overlap is >t AND response is higher for new kpt
-                            *it = newKeyPoint; // replace old key point with new one
-                            break;             // quit loop over keypoints
-                        }
-                    }
-                }
-                if (!bOverlap)
-                {                                     // only add new key point if no overlap has been found in previous NMS
-                    keypoints.push_back(newKeyPoint); // store new keypoint in dynamic list
-                }
-            }
-        } // eof loop over cols
-    }     // eof loop over rows
+    // perform non-maximum suppression (NMS) in local neighbourhood around each new key point,
+    // a spatial grid limits the overlap test to keypoints in adjacent cells
+    vector<cv::KeyPoint> candidates;
+    harris.candidates(minResponse, 2 * apertureSize, candidates);
+    nmsOverlapGrid(candidates, maxOverlap, keypoints);
 
     // visualize keypoints
     windowName = "Harris Corner Detection Results";
@@ -0,0 +1,101 @@
+// check HarrisEngine against cv::cornerHarris and compare their run time
+// usage : harris_verify [image] [repetitions]
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <cmath>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/features2d.hpp>
+
+#include "harrisEngine.hpp"
+#include "nms.hpp"
+
+using namespace std;
+
+int main(int argc, const char *argv[])
+{
+    string imgFile = argc > 1 ? argv[1] : "../images/img0005.png";
+    int repetitions = argc > 2 ? atoi(argv[2]) : 10;
+
+    cv::Mat img = cv::imread(imgFile, cv::IMREAD_GRAYSCALE);
+    if (img.empty())
+    {
+        cout << "could not read image " << imgFile << endl;
+        return 1;
+    }
+
+    // same detector parameters as cornerness_harris
+    int blockSize = 2;
+    int apertureSize = 3;
+    int minResponse = 100;
+    double k = 0.04;
+    double maxOverlap = 0.0;
+
+    // OpenCV : zeros, cornerHarris, normalize, thresholding pass over the normalized image
+    cv::Mat dst, dst_norm;
+    vector<cv::KeyPoint> cvCandidates;
+    double t = (double)cv::getTickCount();
+    for (int r = 0; r < repetitions; ++r)
+    {
+        dst = cv::Mat::zeros(img.size(), CV_32FC1);
+        cv::cornerHarris(img, dst, blockSize, apertureSize, k, cv::BORDER_DEFAULT);
+        cv::normalize(dst, dst_norm, 0, 255, cv::NORM_MINMAX, CV_32FC1, cv::Mat());
+        cvCandidates.clear();
+        for (int j = 0; j < dst_norm.rows; ++j)
+        {
+            for (int i = 0; i < dst_norm.cols; ++i)
+            {
+                float response = dst_norm.at<float>(j, i);
+                if (response > minResponse)
+                {
+                    cvCandidates.push_back(cv::KeyPoint(cv::Point2f(i, j), 2 * apertureSize, -1, response));
+                }
+            }
+        }
+    }
+    double tCv = ((double)cv::getTickCount() - t) / cv::getTickFrequency() / repetitions;
+
+    // engine : one pass for the response, candidates only from tiles which contain any
+    HarrisEngine harris(blockSize, k);
+    vector<cv::KeyPoint> candidates;
+    t = (double)cv::getTickCount();
+    for (int r = 0; r < repetitions; ++r)
+    {
+        harris.compute(img);
+        harris.candidates(minResponse, 2 * apertureSize, candidates);
+    }
+    double tEngine = ((double)cv::getTickCount() - t) / cv::getTickFrequency() / repetitions;
+
+    // the structure tensor sums of the engine are exact integers, OpenCV scales the gradients first,
+    // so the responses agree up to float rounding
+    double maxDiff = cv::norm(dst, harris.response(), cv::NORM_INF);
+    double maxAbs = cv::norm(dst, cv::NORM_INF);
+    double relDiff = maxAbs > 0.0 ? maxDiff / maxAbs : maxDiff;
+
+    cv::Mat engineNorm;
+    harris.normalized(engineNorm);
+    double maxNormDiff = cv::norm(dst_norm, engineNorm, cv::NORM_INF);
+    int bitExact = cv::countNonZero(dst != harris.response());
+    int differentAboveThreshold = cv::countNonZero(cv::Mat(dst_norm > minResponse) != cv::Mat(engineNorm > minResponse));
+
+    vector<cv::KeyPoint> cvKeypoints, engineKeypoints;
+    nmsOverlapGrid(cvCandidates, maxOverlap, cvKeypoints);
+    nmsOverlapGrid(candidates, maxOverlap, engineKeypoints);
+
+    cout << fixed << setprecision(3)
+         << "cv::cornerHarris + normalize + threshold : " << 1000 * tCv << " ms" << endl
+         << "HarrisEngine compute + candidates       : " << 1000 * tEngine << " ms" << endl
+         << scientific << setprecision(2)
+         << "max. response difference : " << maxDiff << " (" << relDiff << " of the max. response)" << endl
+         << "max. normalized difference : " << maxNormDiff << endl
+         << "pixels not bit-exact : " << bitExact << " of " << img.total() << endl
+         << "pixels on a different side of the threshold : " << differentAboveThreshold << endl
+         << "candidates : " << cvCandidates.size() << " / " << candidates.size()
+         << ", keypoints after NMS : " << cvKeypoints.size() << " / " << engineKeypoints.size() << endl;
+
+    // float rounding may move single pixels across the threshold, larger deviations are an error
+    return relDiff < 1e-5 ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+// compare the run time of the non-maximum suppression modes on the Harris response of an image
+// usage : nms_benchmark [image] [repetitions]
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/features2d.hpp>
+
+#include "nms.hpp"
+
+using namespace std;
+
+static bool sameKeypoints(const vector<cv::KeyPoint> &a, const vector<cv::KeyPoint> &b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (a[i].pt != b[i].pt || a[i].response != b[i].response)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, const char *argv[])
+{
+    string imgFile = argc > 1 ? argv[1] : "../images/img0005.png";
+    int repetitions = argc > 2 ? atoi(argv[2]) : 5;
+
+    cv::Mat img = cv::imread(imgFile, cv::IMREAD_GRAYSCALE);
+    if (img.empty())
+    {
+        cout << "could not read image " << imgFile << endl;
+        return 1;
+    }
+
+    // same detector parameters as cornerness_harris
+    int blockSize = 2;
+    int apertureSize = 3;
+    double k = 0.04;
+    double maxOverlap = 0.0;
+
+    cv::Mat dst, dst_norm;
+    cv::cornerHarris(img, dst, blockSize, apertureSize, k, cv::BORDER_DEFAULT);
+    cv::normalize(dst, dst_norm, 0, 255, cv::NORM_MINMAX, CV_32FC1, cv::Mat());
+
+    const NmsMode modes[] = {NmsMode::NMS_OVERLAP_LOOP, NmsMode::NMS_GRID, NmsMode::NMS_MAX_FILTER};
+    const char *modeNames[] = {"overlap loop", "grid", "max filter"};
+
+    // lower thresholds produce more candidates, as on strongly textured frames
+    bool bIdentical = true;
+    cout << setw(12) << "minResponse" << setw(14) << "mode" << setw(12) << "keypoints" << setw(12) << "time [ms]" << endl;
+    for (float minResponse : {100.0f, 50.0f, 20.0f})
+    {
+        vector<cv::KeyPoint> reference;
+        for (int m = 0; m < 3; ++m)
+        {
+            vector<cv::KeyPoint> keypoints;
+            double t = (double)cv::getTickCount();
+            for (int r = 0; r < repetitions; ++r)
+            {
+                nonMaximumSuppression(dst_norm, minResponse, 2 * apertureSize, maxOverlap, modes[m], keypoints);
+            }
+            t = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
+            cout << setw(12) << minResponse << setw(14) << modeNames[m] << setw(12) << keypoints.size()
+                 << setw(12) << 1000 * t / repetitions << endl;
+
+            if (modes[m] == NmsMode::NMS_OVERLAP_LOOP)
+            {
+                reference = keypoints;
+            }
+            else if (modes[m] == NmsMode::NMS_GRID && !sameKeypoints(reference, keypoints))
+            {
+                cout << "grid NMS differs from the overlap loop" << endl;
+                bIdentical = false;
+            }
+        }
+    }
+    return bIdentical ? 0 : 1;
+}
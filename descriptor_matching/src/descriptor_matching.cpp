@@ -6,6 +6,7 @@
 #include <opencv2/features2d.hpp>
 
 #include "structIO.hpp"
+#include "mihIndex.hpp"
 
 using namespace std;
 
@@ -16,6 +17,7 @@ void matchDescriptors(cv::Mat &imgSource, cv::Mat &imgRef, vector<cv::KeyPoint>
     // configure matcher
     bool crossCheck = false;
     cv::Ptr<cv::DescriptorMatcher> matcher;
+    MihIndex mih; // replaces the FLANN matcher for binary descriptors
 
     if (matcherType.compare("MAT_BF") == 0)
     {
@@ -27,13 +29,15 @@ void matchDescriptors(cv::Mat &imgSource, cv::Mat &imgRef, vector<cv::KeyPoint>
     else if (matcherType.compare("MAT_FLANN") == 0)
     {
         if (descSource.type() != CV_32F)
-        { // OpenCV bug workaround : convert binary descriptors to floating point due to a bug in current OpenCV implementation
-            descSource.convertTo(descSource, CV_32F);
-            descRef.convertTo(descRef, CV_32F);
+        { // binary descriptors are indexed by multi-index hashing on their own bits, exact under the Hamming distance
+            mih.build(descRef);
+            cout << "MIH matching with " << mih.substrings() << " substrings";
+        }
+        else
+        {
+            matcher = cv::DescriptorMatcher::create(cv::DescriptorMatcher::FLANNBASED);
+            cout << "FLANN matching";
         }
-
-        matcher = cv::DescriptorMatcher::create(cv::DescriptorMatcher::FLANNBASED);
-        cout << "FLANN matching";
     }
 
     // perform matching task
@@ -41,7 +45,14 @@ void matchDescriptors(cv::Mat &imgSource, cv::Mat &imgRef, vector<cv::KeyPoint>
     { // nearest neighbor (best match)
 
         double t = (double)cv::getTickCount();
-        matcher->match(descSource, descRef, matches); // Finds the best match for each descriptor in desc1
+        if (matcher)
+        {
+            matcher->match(descSource, descRef, matches); // Finds the best match for each descriptor in desc1
+        }
+        else
+        {
+            mih.match(descSource, 0.0, matches);
+        }
         t = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
         cout << " (NN) with n=" << matches.size() << " matches in " << 1000 * t / 1.0 << " ms" << endl;
     }
@@ -50,7 +61,14 @@ void matchDescriptors(cv::Mat &imgSource, cv::Mat &imgRef, vector<cv::KeyPoint>
 
         vector<vector<cv::DMatch>> knn_matches;
         double t = (double)cv::getTickCount();
-        matcher->knnMatch(descSource, descRef, knn_matches, 2); // finds the 2 best matches
+        if (matcher)
+        {
+            matcher->knnMatch(descSource, descRef, knn_matches, 2); // finds the 2 best matches
+        }
+        else
+        {
+            mih.knnMatch(descSource, 2, knn_matches);
+        }
         t = ((double)cv::getTickCount() - t) / cv::getTickFrequency();
         cout << " (KNN) with n=" << knn_matches.size() << " matches in " << 1000 * t / 1.0 << " ms" << endl;
 
@@ -0,0 +1,220 @@
+// compare the brute-force matchers in common/src with cv::BFMatcher :
+// HammingMatcher on the BRISK descriptors of the exercise and on random descriptors of ORB (32 bytes) and
+// BRISK (64 bytes) length at 1000 - 5000 descriptors per frame, the MihIndex search on the same binary descriptors,
+// L2Matcher on the SIFT descriptors of the exercise, followed by the scaling of both brute-force matchers with the no. of
+// threads on BRISK_large and SIFT
+// usage : matcher_benchmark [repetitions]
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <functional>
+#include <thread>
+#include <cstdlib>
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+
+#include "structIO.hpp"
+#include "hammingMatcher.hpp"
+#include "l2Matcher.hpp"
+#include "mihIndex.hpp"
+
+using namespace std;
+
+typedef function<void(const cv::Mat &descSource, const cv::Mat &descRef, vector<cv::DMatch> &matches)> MatchFunction;
+
+// knnMatch with k = 2 followed by the ratio test as in matchDescriptors, or a cross-checked nearest neighbor search
+static void matchOpenCv(int normType, bool bCrossCheck, const cv::Mat &descSource, const cv::Mat &descRef, vector<cv::DMatch> &matches)
+{
+    cv::BFMatcher matcher(normType, bCrossCheck);
+    matches.clear();
+    if (bCrossCheck)
+    {
+        matcher.match(descSource, descRef, matches);
+        return;
+    }
+
+    vector<vector<cv::DMatch> > knn_matches;
+    matcher.knnMatch(descSource, descRef, knn_matches, 2);
+    double minDescDistRatio = 0.8;
+    for (const auto &knn : knn_matches)
+    {
+        if (knn.size() == 2 && knn[0].distance < minDescDistRatio * knn[1].distance)
+        {
+            matches.push_back(knn[0]);
+        }
+    }
+}
+
+// fraction of the reference matches which were found with the same train descriptor
+static double agreement(const vector<cv::DMatch> &reference, const vector<cv::DMatch> &matches)
+{
+    vector<int> trainIdx;
+    for (const cv::DMatch &m : matches)
+    {
+        trainIdx.resize(max<size_t>(trainIdx.size(), m.queryIdx + 1), -1);
+        trainIdx[m.queryIdx] = m.trainIdx;
+    }
+    size_t same = 0;
+    for (const cv::DMatch &m : reference)
+    {
+        same += m.queryIdx < (int)trainIdx.size() && trainIdx[m.queryIdx] == m.trainIdx;
+    }
+    size_t total = max(reference.size(), matches.size());
+    return total > 0 ? static_cast<double>(same) / total : 1.0;
+}
+
+static double timeMatching(const function<void()> &run, int repetitions)
+{
+    double t = (double)cv::getTickCount();
+    for (int r = 0; r < repetitions; ++r)
+    {
+        run();
+    }
+    return ((double)cv::getTickCount() - t) / cv::getTickFrequency() / repetitions;
+}
+
+static bool sameMatches(const vector<cv::DMatch> &a, const vector<cv::DMatch> &b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (a[i].queryIdx != b[i].queryIdx || a[i].trainIdx != b[i].trainIdx || a[i].distance != b[i].distance)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// run time of matchFunction on pools of 1, 2, 4, ... threads up to the no. of cores,
+// returns false if the matches change with the no. of threads
+typedef function<void(const cv::Mat &descSource, const cv::Mat &descRef, vector<cv::DMatch> &matches, ThreadPool *pool)> PoolMatchFunction;
+static bool scaling(const string &name, const PoolMatchFunction &matchFunction, const cv::Mat &descSource, const cv::Mat &descRef,
+                    int repetitions)
+{
+    int maxThreads = max(1u, thread::hardware_concurrency());
+    vector<cv::DMatch> reference, matches;
+    double tSingle = 0.0;
+    bool bSame = true;
+    for (int numThreads = 1; ; numThreads = min(2 * numThreads, maxThreads))
+    {
+        ThreadPool pool(numThreads);
+        double t = timeMatching([&]() { matchFunction(descSource, descRef, matches, &pool); }, repetitions);
+        if (numThreads == 1)
+        {
+            reference = matches;
+            tSingle = t;
+        }
+        bool bSameThreads = sameMatches(reference, matches);
+        bSame &= bSameThreads;
+        cout << setw(28) << name << setw(8) << numThreads << setw(12) << 1000 * t << setw(10) << tSingle / t
+             << (bSameThreads ? "" : "  MISMATCH") << endl;
+        if (numThreads == maxThreads)
+        {
+            break;
+        }
+    }
+    return bSame;
+}
+
+// prints one result line, returns false if an exact matcher disagrees with OpenCV
+static bool compare(const string &name, int normType, bool bCrossCheck, const MatchFunction &matchFunction,
+                    const cv::Mat &descSource, const cv::Mat &descRef, int repetitions)
+{
+    vector<cv::DMatch> reference, matches;
+    double tBf = timeMatching([&]() { matchOpenCv(normType, bCrossCheck, descSource, descRef, reference); }, repetitions);
+    double tOwn = timeMatching([&]() { matchFunction(descSource, descRef, matches); }, repetitions);
+
+    // L2 distances are rounded differently, so near ties may resolve to another descriptor
+    double same = agreement(reference, matches);
+    bool bExact = normType == cv::NORM_HAMMING;
+    cout << setw(28) << name << setw(8) << descSource.rows << setw(8) << matches.size()
+         << setw(12) << 1000 * tBf << setw(12) << 1000 * tOwn << setw(10) << tBf / tOwn
+         << setw(10) << 100 * same << (bExact && same < 1.0 ? "  MISMATCH" : "") << endl;
+    return !bExact || same == 1.0;
+}
+
+// MihIndex of descRef with the ratio test, the index is built once outside of the timing as for a keyframe database,
+// prints the share of descriptor pairs whose distance was computed
+static bool compareMih(const string &name, const cv::Mat &descSource, const cv::Mat &descRef, int repetitions)
+{
+    MihIndex mih;
+    mih.build(descRef);
+    size_t compared = 0;
+    bool bSame = compare(name, cv::NORM_HAMMING, false,
+                         [&](const cv::Mat &s, const cv::Mat &, vector<cv::DMatch> &m) { compared = mih.match(s, 0.8, m); },
+                         descSource, descRef, repetitions);
+    cout << setw(28) << "" << "  " << mih.substrings() << " substrings, "
+         << 100.0 * compared / (static_cast<double>(descSource.rows) * descRef.rows) << " % of the pairs compared" << endl;
+    return bSame;
+}
+
+int main(int argc, const char *argv[])
+{
+    int repetitions = argc > 1 ? atoi(argv[1]) : 10;
+    cout << "Hamming kernel : " << HammingMatcher::kernelName() << endl;
+    cout << setw(28) << "descriptors" << setw(8) << "n" << setw(8) << "matches" << setw(12) << "BF [ms]"
+         << setw(12) << "own [ms]" << setw(10) << "speedup" << setw(10) << "same [%]" << endl;
+
+    HammingMatcher hamming;
+    MatchFunction hammingRatio = [&](const cv::Mat &s, const cv::Mat &r, vector<cv::DMatch> &m) { hamming.match(s, r, 0.8, false, m); };
+
+    bool bSame = true;
+    for (string size : {"small", "large"})
+    {
+        cv::Mat descSource, descRef;
+        readDescriptors(("../dat/C35A5_DescSource_BRISK_" + size + ".dat").c_str(), descSource);
+        readDescriptors(("../dat/C35A5_DescRef_BRISK_" + size + ".dat").c_str(), descRef);
+        bSame &= compare("BRISK_" + size + " KNN", cv::NORM_HAMMING, false, hammingRatio, descSource, descRef, repetitions);
+        bSame &= compare("BRISK_" + size + " NN cross-check", cv::NORM_HAMMING, true,
+                         [&](const cv::Mat &s, const cv::Mat &r, vector<cv::DMatch> &m) { hamming.match(s, r, 0.0, true, m); },
+                         descSource, descRef, repetitions);
+        bSame &= compareMih("BRISK_" + size + " KNN MIH", descSource, descRef, repetitions);
+    }
+
+    // random descriptors, the second frame is the first with a few flipped bits so that the ratio test passes
+    cv::RNG rng(42);
+    for (int bytes : {32, 64})
+    {
+        for (int n : {1000, 2000, 5000})
+        {
+            cv::Mat descSource(n, bytes, CV_8UC1);
+            rng.fill(descSource, cv::RNG::UNIFORM, 0, 256);
+            cv::Mat descRef = descSource.clone();
+            for (int flip = 0; flip < n * bytes; ++flip)
+            { // about one flipped bit per byte
+                descRef.at<uchar>(rng.uniform(0, n), rng.uniform(0, bytes)) ^= static_cast<uchar>(1 << rng.uniform(0, 8));
+            }
+            bSame &= compare("random " + to_string(bytes) + " bytes KNN", cv::NORM_HAMMING, false, hammingRatio,
+                             descSource, descRef, repetitions);
+            bSame &= compareMih("random " + to_string(bytes) + " bytes KNN MIH", descSource, descRef, repetitions);
+        }
+    }
+
+    // SIFT, about 1.9k x 128 floats per frame
+    cv::Mat siftSource, siftRef;
+    readDescriptors("../dat/C35A5_DescSource_SIFT.dat", siftSource);
+    readDescriptors("../dat/C35A5_DescRef_SIFT.dat", siftRef);
+    L2Matcher l2;
+    compare("SIFT KNN", cv::NORM_L2, false,
+            [&](const cv::Mat &s, const cv::Mat &r, vector<cv::DMatch> &m) { l2.match(s, r, 0.8, false, m); },
+            siftSource, siftRef, repetitions);
+    compare("SIFT NN cross-check", cv::NORM_L2, true,
+            [&](const cv::Mat &s, const cv::Mat &r, vector<cv::DMatch> &m) { l2.match(s, r, 0.0, true, m); },
+            siftSource, siftRef, repetitions);
+
+    cout << endl << setw(28) << "descriptors" << setw(8) << "threads" << setw(12) << "time [ms]" << setw(10) << "speedup" << endl;
+    cv::Mat briskSource, briskRef;
+    readDescriptors("../dat/C35A5_DescSource_BRISK_large.dat", briskSource);
+    readDescriptors("../dat/C35A5_DescRef_BRISK_large.dat", briskRef);
+    bSame &= scaling("BRISK_large KNN", [&](const cv::Mat &s, const cv::Mat &r, vector<cv::DMatch> &m, ThreadPool *pool) {
+        hamming.match(s, r, 0.8, false, m, pool);
+    }, briskSource, briskRef, repetitions);
+    bSame &= scaling("SIFT KNN", [&](const cv::Mat &s, const cv::Mat &r, vector<cv::DMatch> &m, ThreadPool *pool) {
+        l2.match(s, r, 0.8, false, m, pool);
+    }, siftSource, siftRef, repetitions);
+    return bSame ? 0 : 1;
+}